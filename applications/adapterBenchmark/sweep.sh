@@ -0,0 +1,52 @@
+#!/bin/bash
+# Mesh-size sweep of adapterBenchmark: refines a copy of the cavity_temp
+# case to block meshes of about 10^4, 10^5, 10^6 and 10^7 cells (or the
+# given cells per direction) and times configureMesh and the read/write
+# paths of the adapter on each, serially or on NP ranks. Build the adapter
+# (Allwmake) and this application (wmake) first.
+#
+#   ./sweep.sh                  # 22 47 100 216 cells per direction
+#   NP=4 WINDOWS=50 ./sweep.sh 100 216
+#
+# Results: sweep/adapter-benchmark.csv and the logs.
+set -e -u
+
+sizes="${*:-22 47 100 216}"
+np="${NP:-1}"
+windows="${WINDOWS:-100}"
+
+here="$(pwd)"
+root="$(cd ../.. && pwd)"
+out="$here/sweep"
+mkdir -p "$out"
+csv="$out/adapter-benchmark.csv"
+rm -f "$csv"
+
+# Copy of the case next to the original, so that ../precice-config.xml
+# stays valid
+bench="$root/cavity_temp_benchmark"
+trap 'rm -rf "$bench"' EXIT
+rm -rf "$bench"
+mkdir "$bench"
+cp -r "$root/cavity_temp/0" "$root/cavity_temp/constant" "$root/cavity_temp/system" "$bench"
+cd "$bench"
+
+for n in $sizes; do
+    echo "Mesh of $n^3 cells..."
+    rm -rf processor* constant/polyMesh
+    foamDictionary system/blockMeshDict -entry blocks \
+        -set "(hex (0 1 2 3 4 5 6 7) ($n $n $n) simpleGrading (1 1 1))" > /dev/null
+    blockMesh > "$out/log.blockMesh.$n" 2>&1
+
+    if [ "$np" -gt 1 ]; then
+        foamDictionary system/decomposeParDict -entry numberOfSubdomains -set "$np" > /dev/null
+        decomposePar -force > "$out/log.decomposePar.$n" 2>&1
+        mpirun -np "$np" adapterBenchmark -parallel -windows "$windows" -csv "$csv" \
+            > "$out/log.adapterBenchmark.$n" 2>&1
+    else
+        adapterBenchmark -windows "$windows" -csv "$csv" > "$out/log.adapterBenchmark.$n" 2>&1
+    fi
+done
+
+cd "$here"
+column -s, -t < "$csv"
@@ -19,6 +19,7 @@ fi
 # Remove other common OpenFOAM generated files
 echo "Removing other generated files..."
 rm -rf processor*/ # For parallel runs
+rm -rf scaling/ # Results of scaling.sh
 rm -f *.dat *.vtk # Data files
 rm -f *.csv # CSV output
 rm -f *~  # Temporary files
@@ -0,0 +1,107 @@
+#!/bin/bash
+# Strong scaling of the OpenFOAM participant on one host: runs the coupled
+# case with 1, 2, 4 and 8 MPI ranks (or the given counts) on the cavity_temp
+# mesh refined REFINE times in each direction (default 2: 100^3 cells), for
+# WINDOWS coupling windows (default 200). The cells participant runs
+# serially and must be built (bdm build in ../cells).
+#
+#   ./scaling.sh                # 1 2 4 8 ranks
+#   REFINE=3 ./scaling.sh 2 4
+#
+# Results: scaling/scaling.csv (wall time of the coupled run, CPU time of
+# OpenFOAM, speedup and efficiency against the first count) and the logs.
+set -e -u
+
+ranks="${*:-1 2 4 8}"
+refine="${REFINE:-2}"
+windows="${WINDOWS:-200}"
+
+here="$(pwd)"
+root="$(cd .. && pwd)"
+out="$here/scaling"
+mkdir -p "$out"
+
+if [ ! -x "$root/cells/build/cells" ]; then
+    echo "Build the cells participant first (bdm build in $root/cells)"
+    exit 1
+fi
+
+# Copies of the case and of the preCICE configuration, next to the
+# originals, so that the relative paths (../precice-*.xml and the exchange
+# directory of preCICE) stay valid
+bench="$root/cavity_temp_scaling"
+config="$root/precice-config-scaling.xml"
+trap 'rm -rf "$bench" "$config" "$root/precice-run"' EXIT
+
+dt=$(sed -n 's|.*<time-window-size value="\([^"]*\)".*|\1|p' "$root/precice-config.xml")
+endTime=$(awk -v n="$windows" -v dt="$dt" 'BEGIN { print n * dt }')
+sed "s|<max-time value=\"[^\"]*\"|<max-time value=\"$endTime\"|" \
+    "$root/precice-config.xml" > "$config"
+
+rm -rf "$bench"
+mkdir "$bench"
+cp -r 0 constant system "$bench"
+cd "$bench"
+
+foamDictionary system/preciceDict -entry preciceConfig -set '"../precice-config-scaling.xml"' > /dev/null
+foamDictionary system/controlDict -entry endTime -set "$endTime" > /dev/null
+foamDictionary system/controlDict -entry writeInterval -set "$endTime" > /dev/null
+
+n=$((50 * refine))
+foamDictionary system/blockMeshDict -entry blocks \
+    -set "(hex (0 1 2 3 4 5 6 7) ($n $n $n) simpleGrading (1 1 1))" > /dev/null
+blockMesh > "$out/log.blockMesh" 2>&1
+topoSet > "$out/log.topoSet" 2>&1
+
+solver=$(foamDictionary system/controlDict -entry application -value)
+nCells=$((n * n * n))
+echo "Mesh: $nCells cells, $windows windows of $dt s, solver $solver"
+
+csv="$out/scaling.csv"
+echo "ranks,cells,windows,wall_s,openfoam_cpu_s,speedup,efficiency" > "$csv"
+
+base=""
+base_ranks=""
+for np in $ranks; do
+    echo "Running with $np rank(s)..."
+    rm -rf processor* "$root/precice-run"
+    foamListTimes -rm > /dev/null 2>&1 || true
+
+    if [ "$np" -gt 1 ]; then
+        foamDictionary system/decomposeParDict -entry numberOfSubdomains -set "$np" > /dev/null
+        decomposePar -force > "$out/log.decomposePar.np$np" 2>&1
+    fi
+
+    (
+        cd "$root/cells"
+        ./build/cells --inline-config \
+            '{"bdm::CouplingParam": {"precice_config": "../precice-config-scaling.xml", "openfoam_case": "../cavity_temp_scaling"}}'
+    ) > "$out/log.cells.np$np" 2>&1 &
+    cells_pid=$!
+
+    start=$(date +%s.%N)
+    if [ "$np" -gt 1 ]; then
+        mpirun -np "$np" "$solver" -parallel > "$out/log.$solver.np$np" 2>&1
+    else
+        "$solver" > "$out/log.$solver.np$np" 2>&1
+    fi
+    end=$(date +%s.%N)
+    wait "$cells_pid"
+
+    wall=$(awk -v a="$start" -v b="$end" 'BEGIN { printf "%.3f", b - a }')
+    cpu=$(sed -n 's/^ExecutionTime = \([0-9.e+-]*\) s.*/\1/p' "$out/log.$solver.np$np" | tail -n 1)
+
+    if [ -z "$base" ]; then
+        base="$wall"
+        base_ranks="$np"
+    fi
+    awk -v np="$np" -v cells="$nCells" -v w="$windows" -v wall="$wall" -v cpu="${cpu:-}" \
+        -v base="$base" -v base_ranks="$base_ranks" 'BEGIN {
+            speedup = base / wall
+            printf "%d,%d,%d,%s,%s,%.3f,%.3f\n",
+                np, cells, w, wall, cpu, speedup, speedup * base_ranks / np
+        }' >> "$csv"
+    tail -n 1 "$csv"
+done
+
+echo "Results written to $csv"
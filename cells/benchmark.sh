@@ -0,0 +1,21 @@
+#!/bin/bash
+# Build and run the coupling benchmarks, and store the results as JSON in
+# benchmark-results/<commit>.json. Compare two runs with compare.py of
+# Google Benchmark:
+#   compare.py benchmarks benchmark-results/A.json benchmark-results/B.json
+# Extra arguments are passed to the benchmark, e.g.
+#   ./benchmark.sh --benchmark_filter=Locator
+set -e -u
+
+# Temporarily disable unbound variable errors
+set +u
+source /home/ale/biodynamo-v1.05.124/bin/thisbdm.sh
+set -u
+
+mkdir -p build benchmark-results
+cmake -S . -B build -DCELLS_BENCHMARKS=ON -DCMAKE_BUILD_TYPE=Release
+cmake --build build --target cells-benchmark -j "$(nproc)"
+
+result="benchmark-results/$(git rev-parse --short HEAD 2>/dev/null || date +%s).json"
+./build/cells-benchmark --benchmark_out="$result" --benchmark_out_format=json "$@"
+echo "Results written to $result"
@@ -0,0 +1,145 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+// Benchmarks of the PreciceAdapter paths of Simulate() (cells.h), coupled to
+// the in-process MockParticipant instead of preCICE. The received VolumeMesh
+// is a block mesh of 47^3 (about 10^5) cells; the number of agents varies.
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "biodynamo.h"
+#include "mock_participant.h"
+#include "my_cell.h"
+#include "precice_adapter.h"
+
+namespace bdm {
+
+// A simulation with `num_agents` MyCells at random positions in the unit cube
+class AgentFixture {
+ public:
+  explicit AgentFixture(size_t num_agents) : simulation_("adapter-benchmark") {
+    auto* rm = simulation_.GetResourceManager();
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    for (size_t i = 0; i < num_agents; ++i) {
+      auto* cell = new MyCell({dist(rng), dist(rng), dist(rng)});
+      cell->SetHeatRelease(1e-3);
+      rm->AddAgent(cell);
+    }
+  }
+
+  Simulation& GetSimulation() { return simulation_; }
+
+  // An initialized adapter, coupled to a MockParticipant, that reads
+  // `num_fields` scalar fields (the temperature and num_fields - 1 others)
+  std::unique_ptr<PreciceAdapter> MakeAdapter(bool just_in_time,
+                                              int num_fields = 1) {
+    std::unique_ptr<PreciceAdapter> adapter(new PreciceAdapter(
+        std::unique_ptr<CouplingParticipant>(new MockParticipant(47, 1.0)),
+        just_in_time));
+    for (int f = 1; f < num_fields; ++f) {
+      adapter->AddReadField("C" + std::to_string(f), 1);
+    }
+    adapter->SetAccessRegion({0.0, 1.0, 0.0, 1.0, 0.0, 1.0});
+    adapter->UpdateMesh(simulation_);
+    adapter->Initialize();
+    return adapter;
+  }
+
+ private:
+  Simulation simulation_;
+};
+
+static void AgentCounts(benchmark::internal::Benchmark* b) {
+  for (int n : {1000, 10000, 100000}) {
+    b->Arg(n);
+  }
+}
+
+// Registering the agents as the CellMesh (mesh mode, once) or collecting the
+// sample points (just-in-time mapping, every window)
+static void BM_AdapterUpdateMesh(benchmark::State& state) {
+  AgentFixture fixture(state.range(0));
+  const bool just_in_time = state.range(1) != 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<PreciceAdapter> adapter(new PreciceAdapter(
+        std::unique_ptr<CouplingParticipant>(new MockParticipant(47, 1.0)),
+        just_in_time));
+    state.ResumeTiming();
+    adapter->UpdateMesh(fixture.GetSimulation());
+    state.PauseTiming();
+    adapter.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AdapterUpdateMesh)
+    ->ArgsProduct({{1000, 10000, 100000}, {0, 1}})
+    ->ArgNames({"agents", "jit"})
+    ->Unit(benchmark::kMillisecond);
+
+// Per-window read of the temperature (and further fields) into the field
+// store
+static void BM_AdapterReadFields(benchmark::State& state) {
+  AgentFixture fixture(state.range(0));
+  auto adapter = fixture.MakeAdapter(false, state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(adapter->ReadFields());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AdapterReadFields)
+    ->ArgsProduct({{1000, 10000, 100000}, {1, 4}})
+    ->ArgNames({"agents", "fields"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Per-window deposit and write of the agent heat release
+static void BM_AdapterWriteHeatRelease(benchmark::State& state) {
+  AgentFixture fixture(state.range(0));
+  auto adapter = fixture.MakeAdapter(false);
+  for (auto _ : state) {
+    adapter->WriteHeatRelease();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AdapterWriteHeatRelease)
+    ->Apply(AgentCounts)
+    ->Unit(benchmark::kMicrosecond);
+
+// Per-step application of the temperature to the agents in Simulate():
+// statistics and colors over the store, then the copy into the agents that
+// the visualization exports
+static void BM_AdapterApplyFields(benchmark::State& state) {
+  AgentFixture fixture(state.range(0));
+  auto adapter = fixture.MakeAdapter(false);
+  adapter->ReadFields();
+  const bool sync_agents = state.range(1) != 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(adapter->ApplyFields());
+    if (sync_agents) {
+      adapter->SyncAgents();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AdapterApplyFields)
+    ->ArgsProduct({{1000, 10000, 100000}, {0, 1}})
+    ->ArgNames({"agents", "sync"})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace bdm
@@ -0,0 +1,20 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+
+#include <benchmark/benchmark.h>
+
+// All *.cc files in benchmark/ are linked into cells-benchmark. Run it with
+// ./benchmark.sh, which stores the results as JSON.
+BENCHMARK_MAIN();
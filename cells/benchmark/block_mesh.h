@@ -0,0 +1,29 @@
+#ifndef BLOCK_MESH_H_
+#define BLOCK_MESH_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace bdm {
+
+// Cell centres of a block mesh of n x n x n cells over the unit cube, in the
+// order of blockMesh (x fastest)
+inline std::vector<double> BlockMeshCentres(int n) {
+  std::vector<double> centres(3 * static_cast<size_t>(n) * n * n);
+  const double h = 1.0 / n;
+  size_t c = 0;
+  for (int k = 0; k < n; ++k) {
+    for (int j = 0; j < n; ++j) {
+      for (int i = 0; i < n; ++i) {
+        centres[c++] = (i + 0.5) * h;
+        centres[c++] = (j + 0.5) * h;
+        centres[c++] = (k + 0.5) * h;
+      }
+    }
+  }
+  return centres;
+}
+
+}  // namespace bdm
+
+#endif  // BLOCK_MESH_H_
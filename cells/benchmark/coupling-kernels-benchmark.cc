@@ -0,0 +1,213 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+// Benchmarks of the coupling kernels that do not need BioDynaMo or preCICE.
+// The mesh sizes are block meshes of n^3 cells, n = 22, 47, 100, 216
+// (about 10^4 to 10^7 cells).
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "block_mesh.h"
+#include "cell_locator.h"
+#include "coupled_field_store.h"
+#include "scatter_add.h"
+
+namespace bdm {
+
+// Number of OpenMP threads for the lifetime of a benchmark
+class ThreadCount {
+ public:
+  explicit ThreadCount(int threads) {
+#ifdef _OPENMP
+    previous_ = omp_get_max_threads();
+    omp_set_num_threads(threads);
+#endif
+  }
+  ~ThreadCount() {
+#ifdef _OPENMP
+    omp_set_num_threads(previous_);
+#endif
+  }
+
+ private:
+  int previous_ = 1;
+};
+
+// Random points in the unit cube
+static std::vector<double> RandomPoints(size_t n) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  std::vector<double> points(3 * n);
+  for (auto& x : points) {
+    x = dist(rng);
+  }
+  return points;
+}
+
+static void MeshSizes(benchmark::internal::Benchmark* b) {
+  for (int n : {22, 47, 100, 216}) {
+    b->Arg(n);
+  }
+}
+
+// Indexing the cell centres of the OpenFOAM mesh (done once per run, and
+// again for the received VolumeMesh)
+static void BM_LocatorBuild(benchmark::State& state) {
+  const auto centres = BlockMeshCentres(state.range(0));
+  const size_t num_cells = centres.size() / 3;
+  for (auto _ : state) {
+    CellLocator locator;
+    locator.SetCellCentres(centres.data(), num_cells);
+    benchmark::DoNotOptimize(locator.GetNumCells());
+  }
+  state.counters["cells"] = num_cells;
+  state.SetItemsProcessed(state.iterations() * num_cells);
+}
+BENCHMARK(BM_LocatorBuild)->Apply(MeshSizes)->Unit(benchmark::kMillisecond);
+
+// Mapping 10^5 agents to cells (UpdateMesh, and every window with
+// just-in-time mapping)
+static void BM_LocatorFindCells(benchmark::State& state) {
+  const auto centres = BlockMeshCentres(state.range(0));
+  CellLocator locator;
+  locator.SetCellCentres(centres.data(), centres.size() / 3);
+  const size_t num_agents = 100000;
+  const auto points = RandomPoints(num_agents);
+  std::vector<int64_t> cells(num_agents);
+  for (auto _ : state) {
+    locator.FindCells(points.data(), num_agents, cells.data());
+    benchmark::DoNotOptimize(cells.data());
+  }
+  state.counters["cells"] = centres.size() / 3;
+  state.SetItemsProcessed(state.iterations() * num_agents);
+}
+BENCHMARK(BM_LocatorFindCells)->Apply(MeshSizes)->Unit(benchmark::kMillisecond);
+
+// Temperature statistics and colors, per read (ApplyTemperature)
+static void BM_StoreApplyTemperature(benchmark::State& state) {
+  const size_t num_vertices = state.range(0);
+  CoupledFieldStore store;
+  const size_t field = store.AddField("T", 1);
+  store.Resize(num_vertices);
+  double* values = store.Data(field);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    values[i] = 300.0 + (i % 150);
+  }
+  for (auto _ : state) {
+    store.MapToColors(field, 300.0, 450.0);
+    benchmark::DoNotOptimize(store.ScalarStats(field));
+  }
+  state.SetItemsProcessed(state.iterations() * num_vertices);
+  state.SetBytesProcessed(state.iterations() * num_vertices * 4 * sizeof(double));
+}
+BENCHMARK(BM_StoreApplyTemperature)
+    ->RangeMultiplier(10)
+    ->Range(10000, 10000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// Statistics of several fields and the temperature colors in one blocked
+// pass (ApplyFields), against one pass per field
+static void BM_StoreApplyFields(benchmark::State& state) {
+  const size_t num_vertices = 1000000;
+  const int num_fields = state.range(0);
+  const bool one_pass = state.range(1) != 0;
+  CoupledFieldStore store;
+  std::vector<size_t> fields;
+  for (int f = 0; f < num_fields; ++f) {
+    fields.push_back(store.AddField("F" + std::to_string(f), 1));
+  }
+  store.Resize(num_vertices);
+  for (size_t field : fields) {
+    double* values = store.Data(field);
+    for (size_t i = 0; i < num_vertices; ++i) {
+      values[i] = 300.0 + ((i + field) % 150);
+    }
+  }
+  std::vector<FieldStats> stats(num_fields);
+  for (auto _ : state) {
+    if (one_pass) {
+      store.Apply(fields, fields[0], 300.0, 450.0, &stats);
+    } else {
+      store.MapToColors(fields[0], 300.0, 450.0);
+      for (int f = 0; f < num_fields; ++f) {
+        stats[f] = store.ScalarStats(fields[f]);
+      }
+    }
+    benchmark::DoNotOptimize(stats.data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_vertices);
+}
+BENCHMARK(BM_StoreApplyFields)
+    ->ArgsProduct({{1, 4}, {0, 1}})
+    ->ArgNames({"fields", "one_pass"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Grouping the agents by target cell (whenever the agents move to another
+// cell, i.e. every window with just-in-time mapping) and depositing their
+// heat (every window), with 1 to 8 threads
+static void BM_ScatterAddBuild(benchmark::State& state) {
+  const int64_t num_cells = 100 * 100 * 100;
+  const size_t num_agents = state.range(0);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int64_t> dist(0, num_cells - 1);
+  std::vector<int64_t> targets(num_agents);
+  for (auto& t : targets) {
+    t = dist(rng);
+  }
+  ThreadCount threads(state.range(1));
+  ScatterAddPlan plan;
+  for (auto _ : state) {
+    plan.Build(targets.data(), num_agents, num_cells);
+    benchmark::DoNotOptimize(plan.GetNumTargets());
+  }
+  state.SetItemsProcessed(state.iterations() * num_agents);
+}
+BENCHMARK(BM_ScatterAddBuild)
+    ->ArgsProduct({{10000, 100000, 1000000}, {1, 2, 4, 8}})
+    ->ArgNames({"agents", "threads"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ScatterAddApply(benchmark::State& state) {
+  const int64_t num_cells = 100 * 100 * 100;
+  const size_t num_agents = state.range(0);
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int64_t> dist(0, num_cells - 1);
+  std::vector<int64_t> targets(num_agents);
+  for (auto& t : targets) {
+    t = dist(rng);
+  }
+  ScatterAddPlan plan;
+  plan.Build(targets.data(), num_agents, num_cells);
+  std::vector<double> heat(num_agents, 1e-3);
+  std::vector<double> sums(num_cells);
+  for (auto _ : state) {
+    plan.Apply(heat.data(), sums.data());
+    benchmark::DoNotOptimize(sums.data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_agents);
+}
+BENCHMARK(BM_ScatterAddApply)
+    ->RangeMultiplier(10)
+    ->Range(10000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace bdm
@@ -0,0 +1,109 @@
+#ifndef MOCK_PARTICIPANT_H_
+#define MOCK_PARTICIPANT_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "block_mesh.h"
+#include "cell_locator.h"
+#include "coupling_participant.h"
+
+namespace bdm {
+
+// In-process stand-in for preCICE: the "OpenFOAM" side is a block mesh whose
+// cell centres are received as the VolumeMesh, with a fixed temperature
+// field. Reads copy the field values of the requested vertices (our own
+// vertices get the value of the nearest cell centre, like a nearest-neighbor
+// mapping), writes are summed so that they cannot be optimized away. There
+// is no communication, so the benchmarks measure our side of the coupling.
+class MockParticipant : public CouplingParticipant {
+ public:
+  MockParticipant(int cells_per_dim, double window_size)
+      : centres_(BlockMeshCentres(cells_per_dim)), window_size_(window_size) {
+    const size_t num_cells = centres_.size() / 3;
+    locator_.SetCellCentres(centres_.data(), num_cells);
+    temperature_.resize(num_cells);
+    for (size_t c = 0; c < num_cells; ++c) {
+      temperature_[c] = 300.0 + 150.0 * centres_[3 * c];
+    }
+  }
+
+  void SetMeshAccessRegion(const std::string&,
+                           precice::span<const double>) override {}
+  void Initialize() override {}
+
+  void SetMeshVertices(const std::string&,
+                       precice::span<const double> coordinates,
+                       precice::span<int> ids) override {
+    const size_t offset = vertex_cells_.size();
+    const size_t n = coordinates.size() / 3;
+    vertex_cells_.resize(offset + n);
+    locator_.FindNearestCells(coordinates.data(), n, &vertex_cells_[offset]);
+    for (size_t i = 0; i < n; ++i) {
+      ids[i] = offset + i;
+    }
+  }
+
+  int GetMeshVertexSize(const std::string&) override {
+    return temperature_.size();
+  }
+  void GetMeshVertexIDsAndCoordinates(const std::string&,
+                                      precice::span<int> ids,
+                                      precice::span<double> coordinates) override {
+    for (size_t i = 0; i < ids.size(); ++i) {
+      ids[i] = i;
+    }
+    std::copy(centres_.begin(), centres_.begin() + coordinates.size(),
+              coordinates.data());
+  }
+
+  void ReadData(const std::string& mesh, const std::string&,
+                precice::span<const int> ids, double,
+                precice::span<double> values) override {
+    const bool received = mesh == "VolumeMesh";
+    for (size_t i = 0; i < ids.size(); ++i) {
+      values[i] = temperature_[received ? ids[i] : vertex_cells_[ids[i]]];
+    }
+  }
+
+  void MapAndReadData(const std::string&, const std::string&,
+                      precice::span<const double> coordinates, double,
+                      precice::span<double> values) override {
+    cells_.resize(coordinates.size() / 3);
+    locator_.FindNearestCells(coordinates.data(), cells_.size(), cells_.data());
+    for (size_t i = 0; i < cells_.size(); ++i) {
+      values[i] = temperature_[cells_[i]];
+    }
+  }
+
+  void WriteData(const std::string&, const std::string&,
+                 precice::span<const int>,
+                 precice::span<const double> values) override {
+    for (double v : values) {
+      checksum_ += v;
+    }
+  }
+
+  bool RequiresInitialData() override { return false; }
+  void Advance(double) override {}
+  bool IsCouplingOngoing() override { return true; }
+  double GetMaxTimeStepSize() override { return window_size_; }
+  void Finalize() override {}
+
+  size_t GetNumCells() const { return temperature_.size(); }
+  double GetChecksum() const { return checksum_; }
+
+ private:
+  std::vector<double> centres_;
+  std::vector<double> temperature_;   // One value per cell
+  CellLocator locator_;               // Index of the cell centres
+  std::vector<int64_t> vertex_cells_; // Nearest cell of our vertices
+  std::vector<int64_t> cells_;        // Scratch of MapAndReadData()
+  double window_size_;
+  double checksum_ = 0.0;
+};
+
+}  // namespace bdm
+
+#endif  // MOCK_PARTICIPANT_H_
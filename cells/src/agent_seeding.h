@@ -0,0 +1,179 @@
+#ifndef AGENT_SEEDING_H_
+#define AGENT_SEEDING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cell_locator.h"
+
+namespace bdm {
+
+// Rule for seeding the agents of a new run in the cells of the OpenFOAM
+// mesh, or of a region of it (e.g. a cellSet of topoSet):
+//   lattice: at the centre of the cell nearest to every point of a regular
+//            lattice of `lattice` points per direction over the bounding box
+//            of the region, one agent per cell
+//   cells:   at the centre of every `stride`-th cell of the region
+//   density: `density` agents per unit volume, at random positions in the
+//            cells of the region. The volume of a cell is that of its
+//            bounding box, which is exact for hexahedra aligned with the
+//            axes (blockMesh).
+struct SeedingRule {
+  std::string mode = "lattice";
+  int lattice = 10;
+  int stride = 1;
+  double density = 0.0;
+  uint64_t seed = 0;  // Of the random positions (density)
+};
+
+// Hash of a key (splitmix64). Every cell draws its random numbers from the
+// hash of its own keys, independently of the thread that seeds it.
+inline uint64_t SeedingHash(uint64_t key) {
+  key += 0x9e3779b97f4a7c15ull;
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+  return key ^ (key >> 31);
+}
+
+// Uniform random number in [0, 1) of a key
+inline double SeedingRandom(uint64_t key) {
+  return (SeedingHash(key) >> 11) * 0x1.0p-53;
+}
+
+// Positions (3 per agent) of the agents of `rule` in the `region` cells of
+// the mesh (all cells if empty). Runs in parallel over the cells, the
+// positions do not depend on the number of threads. Returns false (and sets
+// `error`) if the rule cannot be applied.
+inline bool SeedPositions(const CellLocator& mesh,
+                          const std::vector<int64_t>& region,
+                          const SeedingRule& rule,
+                          std::vector<double>* positions, std::string* error) {
+  const int64_t num_mesh_cells = mesh.GetNumCells();
+  for (int64_t cell : region) {
+    if (cell < 0 || cell >= num_mesh_cells) {
+      *error = "cell " + std::to_string(cell) + " of the region is not in the mesh";
+      return false;
+    }
+  }
+  const bool whole_mesh = region.empty();
+  const int64_t num_cells = whole_mesh ? num_mesh_cells : region.size();
+  auto cell_of = [&](int64_t i) { return whole_mesh ? i : region[i]; };
+
+  positions->clear();
+  auto add_centres = [&](const std::vector<int64_t>& cells) {
+    positions->resize(3 * cells.size());
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < static_cast<int64_t>(cells.size()); ++i) {
+      const double* centre = mesh.GetCentre(cells[i]);
+      std::copy(centre, centre + 3, positions->data() + 3 * i);
+    }
+  };
+
+  if (rule.mode == "cells") {
+    const int64_t stride = std::max(1, rule.stride);
+    std::vector<int64_t> cells((num_cells + stride - 1) / stride);
+    for (size_t i = 0; i < cells.size(); ++i) {
+      cells[i] = cell_of(i * stride);
+    }
+    add_centres(cells);
+    return true;
+  }
+
+  if (rule.mode == "lattice") {
+    if (rule.lattice < 1) {
+      *error = "the lattice needs at least one point per direction";
+      return false;
+    }
+    // Bounding box of the centres of the region, the nearest cells of the
+    // region are searched in an index of their centres
+    CellLocator region_locator;
+    const CellLocator* locator = &mesh;
+    if (!whole_mesh) {
+      std::vector<double> centres(3 * num_cells);
+#pragma omp parallel for schedule(static)
+      for (int64_t i = 0; i < num_cells; ++i) {
+        const double* centre = mesh.GetCentre(region[i]);
+        std::copy(centre, centre + 3, &centres[3 * i]);
+      }
+      region_locator.SetCellCentres(centres.data(), num_cells);
+      locator = &region_locator;
+    }
+    const auto& bounds = locator->GetBounds();
+
+    const int64_t n = rule.lattice;
+    std::vector<double> lattice(3 * n * n * n);
+#pragma omp parallel for schedule(static)
+    for (int64_t p = 0; p < n * n * n; ++p) {
+      const int64_t index[3] = {p / (n * n), (p / n) % n, p % n};
+      for (int d = 0; d < 3; ++d) {
+        lattice[3 * p + d] = bounds[2 * d] + (index[d] + 0.5) / n *
+                                                 (bounds[2 * d + 1] - bounds[2 * d]);
+      }
+    }
+    std::vector<int64_t> cells(n * n * n);
+    locator->FindNearestCells(lattice.data(), cells.size(), cells.data());
+
+    // Lattice points in the same (coarse) cell get one agent
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    cells.erase(std::remove(cells.begin(), cells.end(), -1), cells.end());
+    for (int64_t& cell : cells) {
+      cell = cell_of(cell);
+    }
+    add_centres(cells);
+    return true;
+  }
+
+  if (rule.mode == "density") {
+    if (rule.density <= 0) {
+      *error = "the density must be positive";
+      return false;
+    }
+    if (num_cells > 0 && mesh.GetCellBounds(0) == nullptr) {
+      *error = "the density needs the cell bounds (a polyMesh)";
+      return false;
+    }
+    // Number of agents of every cell, then their positions (random in the
+    // bounding box of the cell) at the offsets of the cells
+    std::vector<int64_t> offsets(num_cells + 1, 0);
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < num_cells; ++i) {
+      const int64_t cell = cell_of(i);
+      const double* b = mesh.GetCellBounds(cell);
+      const double expected = rule.density * (b[1] - b[0]) * (b[3] - b[2]) *
+                              (b[5] - b[4]);
+      const double whole = std::floor(expected);
+      const uint64_t key = SeedingHash(rule.seed ^ SeedingHash(cell));
+      offsets[i + 1] = static_cast<int64_t>(whole) +
+                       (SeedingRandom(key) < expected - whole);
+    }
+    for (int64_t i = 0; i < num_cells; ++i) {
+      offsets[i + 1] += offsets[i];
+    }
+
+    positions->resize(3 * offsets[num_cells]);
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (int64_t i = 0; i < num_cells; ++i) {
+      const int64_t cell = cell_of(i);
+      const double* b = mesh.GetCellBounds(cell);
+      uint64_t key = SeedingHash(rule.seed ^ SeedingHash(cell));
+      for (int64_t a = offsets[i]; a < offsets[i + 1]; ++a) {
+        for (int d = 0; d < 3; ++d) {
+          (*positions)[3 * a + d] =
+              b[2 * d] + SeedingRandom(++key) * (b[2 * d + 1] - b[2 * d]);
+        }
+      }
+    }
+    return true;
+  }
+
+  *error = "unknown seeding mode " + rule.mode + " (lattice, cells, density)";
+  return false;
+}
+
+}  // namespace bdm
+
+#endif  // AGENT_SEEDING_H_
@@ -0,0 +1,517 @@
+#ifndef CELL_LOCATOR_H_
+#define CELL_LOCATOR_H_
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bdm {
+
+// Spatial index of the cells of an OpenFOAM mesh, for mapping agent
+// positions to cells.
+// The cell centres (and, if known, the cell bounding boxes) are loaded once,
+// either from an ascii constant/polyMesh or from the vertices of a received
+// preCICE volume mesh. They are binned into a uniform grid with about
+// kCellsPerBin cells per bin, stored contiguously bin by bin. A nearest-cell
+// query searches the bins in growing shells around the point and stops as
+// soon as no closer centre can exist, which is O(1) on average. On graded
+// meshes the nearest centre can belong to a neighbour of the cell that
+// contains the point; FindCell() then searches all cells whose bounding box
+// can reach the point.
+class CellLocator {
+ public:
+  static constexpr int kCellsPerBin = 2;
+  static constexpr int kMaxBinsPerDim = 1024;
+
+  // Load the cells of an ascii OpenFOAM polyMesh directory (points, faces,
+  // owner, neighbour). The cell centre is the mean of its face centres,
+  // which is exact for hexahedra. Returns false if the mesh cannot be read.
+  bool LoadPolyMesh(const std::string& dir, std::string* error = nullptr) {
+    std::vector<double> points;
+    std::vector<int64_t> face_offsets;
+    std::vector<int64_t> face_points;
+    std::vector<int64_t> owner;
+    std::vector<int64_t> neighbour;
+    std::string message;
+    if (!ReadList(dir + "/points", 3, &points, nullptr, &message) ||
+        !ReadList(dir + "/faces", 0, &face_points, &face_offsets, &message) ||
+        !ReadList(dir + "/owner", 1, &owner, nullptr, &message) ||
+        !ReadList(dir + "/neighbour", 1, &neighbour, nullptr, &message)) {
+      if (error != nullptr) {
+        *error = message;
+      }
+      return false;
+    }
+
+    const int64_t num_faces = face_offsets.size() - 1;
+    if (static_cast<int64_t>(owner.size()) != num_faces ||
+        static_cast<int64_t>(neighbour.size()) > num_faces) {
+      if (error != nullptr) {
+        *error = "inconsistent faces/owner/neighbour in " + dir;
+      }
+      return false;
+    }
+
+    int64_t num_cells = 0;
+    for (int64_t cell : owner) {
+      num_cells = std::max(num_cells, cell + 1);
+    }
+
+    std::vector<double> centres(3 * num_cells, 0.0);
+    std::vector<int> num_cell_faces(num_cells, 0);
+    std::vector<double> bounds(6 * num_cells);
+    for (int64_t c = 0; c < num_cells; ++c) {
+      for (int d = 0; d < 3; ++d) {
+        bounds[6 * c + 2 * d] = std::numeric_limits<double>::max();
+        bounds[6 * c + 2 * d + 1] = std::numeric_limits<double>::lowest();
+      }
+    }
+
+    for (int64_t f = 0; f < num_faces; ++f) {
+      double face_centre[3] = {0.0, 0.0, 0.0};
+      double face_bounds[6];
+      for (int d = 0; d < 3; ++d) {
+        face_bounds[2 * d] = std::numeric_limits<double>::max();
+        face_bounds[2 * d + 1] = std::numeric_limits<double>::lowest();
+      }
+      for (int64_t k = face_offsets[f]; k < face_offsets[f + 1]; ++k) {
+        const double* p = &points[3 * face_points[k]];
+        for (int d = 0; d < 3; ++d) {
+          face_centre[d] += p[d];
+          face_bounds[2 * d] = std::min(face_bounds[2 * d], p[d]);
+          face_bounds[2 * d + 1] = std::max(face_bounds[2 * d + 1], p[d]);
+        }
+      }
+      const double n = face_offsets[f + 1] - face_offsets[f];
+
+      const int64_t face_cells[2] = {
+          owner[f], f < static_cast<int64_t>(neighbour.size()) ? neighbour[f] : -1};
+      for (int64_t cell : face_cells) {
+        if (cell < 0) {
+          continue;
+        }
+        for (int d = 0; d < 3; ++d) {
+          centres[3 * cell + d] += face_centre[d] / n;
+          bounds[6 * cell + 2 * d] =
+              std::min(bounds[6 * cell + 2 * d], face_bounds[2 * d]);
+          bounds[6 * cell + 2 * d + 1] =
+              std::max(bounds[6 * cell + 2 * d + 1], face_bounds[2 * d + 1]);
+        }
+        num_cell_faces[cell]++;
+      }
+    }
+    for (int64_t c = 0; c < num_cells; ++c) {
+      for (int d = 0; d < 3; ++d) {
+        centres[3 * c + d] /= std::max(1, num_cell_faces[c]);
+      }
+    }
+
+    cell_bounds_ = std::move(bounds);
+    Build(std::move(centres));
+    return true;
+  }
+
+  // Use the given cell centres (3 coordinates per cell), e.g. the vertices of
+  // a received preCICE volume mesh. The cell bounds are not known, so
+  // FindCell() only checks that the point is inside the mesh bounds.
+  void SetCellCentres(const double* centres, size_t num_cells) {
+    cell_bounds_.clear();
+    Build(std::vector<double>(centres, centres + 3 * num_cells));
+  }
+
+  size_t GetNumCells() const { return centres_.size() / 3; }
+
+  // Centre of a cell (3 coordinates)
+  const double* GetCentre(int64_t cell) const { return &centres_[3 * cell]; }
+
+  // Bounding box of all cells, as {x_min, x_max, y_min, y_max, z_min, z_max}
+  const std::array<double, 6>& GetBounds() const { return bounds_; }
+
+  // Bounding box of a cell (as GetBounds()), nullptr if the cell bounds are
+  // not known (SetCellCentres())
+  const double* GetCellBounds(int64_t cell) const {
+    return cell_bounds_.empty() ? nullptr : &cell_bounds_[6 * cell];
+  }
+
+  // Read an ascii OpenFOAM label list, e.g. the cells of a cellSet in
+  // constant/polyMesh/sets
+  static bool ReadLabels(const std::string& file, std::vector<int64_t>* labels,
+                         std::string* error) {
+    return ReadList(file, 1, labels, nullptr, error);
+  }
+
+  // Is the point inside the bounding box of the mesh?
+  bool InBounds(const double* p, double tolerance = 0.0) const {
+    for (int d = 0; d < 3; ++d) {
+      if (p[d] < bounds_[2 * d] - tolerance ||
+          p[d] > bounds_[2 * d + 1] + tolerance) {
+        return false;
+      }
+    }
+    return !centres_.empty();
+  }
+
+  // Cell with the nearest centre, -1 if there are no cells
+  int64_t FindNearestCell(const double* p) const {
+    if (centres_.empty()) {
+      return -1;
+    }
+
+    int64_t bin[3];
+    for (int d = 0; d < 3; ++d) {
+      bin[d] = BinIndex(p[d], d);
+    }
+
+    int64_t best = -1;
+    double best_dist2 = std::numeric_limits<double>::max();
+    const int64_t max_ring = std::max({dims_[0], dims_[1], dims_[2]});
+    for (int64_t ring = 0; ring <= max_ring; ++ring) {
+      SearchShell(p, bin, ring, &best, &best_dist2,
+                  [](int64_t) { return true; });
+      // Bins of the next shell are at least ring * bin size away
+      const double reach = ring * min_bin_size_;
+      if (best >= 0 && best_dist2 <= reach * reach) {
+        break;
+      }
+    }
+    return sorted_cells_[best];
+  }
+
+  // Cell that contains the point, -1 if the point is outside of the mesh.
+  // This is the cell with the nearest centre among the cells whose bounding
+  // box contains the point (or the cell with the nearest centre, within the
+  // mesh bounds, if the cell bounds are unknown).
+  int64_t FindCell(const double* p, double tolerance = 1e-9) const {
+    if (!InBounds(p, tolerance)) {
+      return -1;
+    }
+    const int64_t cell = FindNearestCell(p);
+    if (cell < 0 || cell_bounds_.empty() ||
+        InCellBounds(cell, p, tolerance)) {
+      return cell;
+    }
+
+    // Graded mesh: a larger neighbour can contain the point. Its centre is
+    // at most max_cell_reach_ away (per direction), so search the shells up
+    // to that distance.
+    int64_t bin[3];
+    for (int d = 0; d < 3; ++d) {
+      bin[d] = BinIndex(p[d], d);
+    }
+    auto contains = [&](int64_t s) {
+      return InCellBounds(sorted_cells_[s], p, tolerance);
+    };
+    int64_t best = -1;
+    double best_dist2 = std::numeric_limits<double>::max();
+    const int64_t max_ring = std::max({dims_[0], dims_[1], dims_[2]});
+    for (int64_t ring = 0; ring <= max_ring; ++ring) {
+      SearchShell(p, bin, ring, &best, &best_dist2, contains);
+      if (ring * min_bin_size_ > max_cell_reach_ + tolerance) {
+        break;
+      }
+    }
+    return best >= 0 ? sorted_cells_[best] : -1;
+  }
+
+  // Batched queries over n points (3 coordinates each), run in parallel
+  void FindNearestCells(const double* points, size_t n, int64_t* cells) const {
+    const int64_t num_points = n;
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < num_points; ++i) {
+      cells[i] = FindNearestCell(&points[3 * i]);
+    }
+  }
+
+  void FindCells(const double* points, size_t n, int64_t* cells) const {
+    const int64_t num_points = n;
+#pragma omp parallel for schedule(static)
+    for (int64_t i = 0; i < num_points; ++i) {
+      cells[i] = FindCell(&points[3 * i]);
+    }
+  }
+
+ private:
+  // Bin the cells into the uniform grid (counting sort by bin)
+  void Build(std::vector<double> centres) {
+    centres_ = std::move(centres);
+    const int64_t num_cells = centres_.size() / 3;
+
+    for (int d = 0; d < 3; ++d) {
+      bounds_[2 * d] = std::numeric_limits<double>::max();
+      bounds_[2 * d + 1] = std::numeric_limits<double>::lowest();
+    }
+    for (int64_t c = 0; c < num_cells; ++c) {
+      for (int d = 0; d < 3; ++d) {
+        bounds_[2 * d] = std::min(bounds_[2 * d], centres_[3 * c + d]);
+        bounds_[2 * d + 1] = std::max(bounds_[2 * d + 1], centres_[3 * c + d]);
+      }
+    }
+    // The mesh extends beyond the outermost centres
+    for (size_t i = 0; i < cell_bounds_.size(); i += 2) {
+      const int d = (i / 2) % 3;
+      bounds_[2 * d] = std::min(bounds_[2 * d], cell_bounds_[i]);
+      bounds_[2 * d + 1] = std::max(bounds_[2 * d + 1], cell_bounds_[i + 1]);
+    }
+    if (num_cells == 0) {
+      bounds_.fill(0.0);
+    }
+
+    // Largest distance (per direction) from a cell centre to its bounds
+    max_cell_reach_ = 0.0;
+    for (size_t i = 0; i < cell_bounds_.size(); i += 2) {
+      const double centre = centres_[3 * (i / 6) + (i / 2) % 3];
+      max_cell_reach_ = std::max({max_cell_reach_, centre - cell_bounds_[i],
+                                  cell_bounds_[i + 1] - centre});
+    }
+
+    // Bin size from the volume (or area, or length) spanned by the centres
+    double extent[3];
+    double max_extent = 0.0;
+    for (int d = 0; d < 3; ++d) {
+      extent[d] = bounds_[2 * d + 1] - bounds_[2 * d];
+      max_extent = std::max(max_extent, extent[d]);
+    }
+    double measure = 1.0;
+    int num_spanned = 0;
+    for (int d = 0; d < 3; ++d) {
+      if (extent[d] > 1e-9 * max_extent) {
+        measure *= extent[d];
+        num_spanned++;
+      }
+    }
+    const double num_bins =
+        std::max<double>(1.0, static_cast<double>(num_cells) / kCellsPerBin);
+    const double bin_size =
+        num_spanned > 0 ? std::pow(measure / num_bins, 1.0 / num_spanned) : 1.0;
+
+    min_bin_size_ = std::numeric_limits<double>::max();
+    for (int d = 0; d < 3; ++d) {
+      dims_[d] = std::min<int64_t>(
+          kMaxBinsPerDim,
+          std::max<int64_t>(1, static_cast<int64_t>(std::ceil(extent[d] / bin_size))));
+      inv_bin_size_[d] = extent[d] > 0.0 ? dims_[d] / extent[d] : 0.0;
+      if (extent[d] > 1e-9 * max_extent) {
+        min_bin_size_ = std::min(min_bin_size_, extent[d] / dims_[d]);
+      }
+    }
+    if (min_bin_size_ == std::numeric_limits<double>::max()) {
+      min_bin_size_ = 0.0;
+    }
+
+    const int64_t total_bins = dims_[0] * dims_[1] * dims_[2];
+    std::vector<int64_t> cell_bins(num_cells);
+    bin_start_.assign(total_bins + 1, 0);
+    for (int64_t c = 0; c < num_cells; ++c) {
+      const double* p = &centres_[3 * c];
+      cell_bins[c] = BinIndex(p[0], 0) +
+                     dims_[0] * (BinIndex(p[1], 1) + dims_[1] * BinIndex(p[2], 2));
+      bin_start_[cell_bins[c] + 1]++;
+    }
+    for (int64_t b = 0; b < total_bins; ++b) {
+      bin_start_[b + 1] += bin_start_[b];
+    }
+
+    std::vector<int64_t> next(bin_start_.begin(), bin_start_.end() - 1);
+    sorted_cells_.resize(num_cells);
+    sorted_centres_.resize(3 * num_cells);
+    for (int64_t c = 0; c < num_cells; ++c) {
+      const int64_t slot = next[cell_bins[c]]++;
+      sorted_cells_[slot] = c;
+      std::copy(&centres_[3 * c], &centres_[3 * c] + 3, &sorted_centres_[3 * slot]);
+    }
+  }
+
+  bool InCellBounds(int64_t cell, const double* p, double tolerance) const {
+    const double* b = &cell_bounds_[6 * cell];
+    for (int d = 0; d < 3; ++d) {
+      if (p[d] < b[2 * d] - tolerance || p[d] > b[2 * d + 1] + tolerance) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int64_t BinIndex(double x, int d) const {
+    const int64_t i = static_cast<int64_t>((x - bounds_[2 * d]) * inv_bin_size_[d]);
+    return std::min(dims_[d] - 1, std::max<int64_t>(0, i));
+  }
+
+  // Check the centres in all bins at Chebyshev distance `ring` from `bin`,
+  // skipping the sorted slots that are not accepted
+  template <typename Accept>
+  void SearchShell(const double* p, const int64_t* bin, int64_t ring,
+                   int64_t* best, double* best_dist2, Accept accept) const {
+    int64_t lo[3];
+    int64_t hi[3];
+    for (int d = 0; d < 3; ++d) {
+      lo[d] = std::max<int64_t>(0, bin[d] - ring);
+      hi[d] = std::min<int64_t>(dims_[d] - 1, bin[d] + ring);
+    }
+    for (int64_t k = lo[2]; k <= hi[2]; ++k) {
+      const bool k_face = std::abs(k - bin[2]) == ring;
+      for (int64_t j = lo[1]; j <= hi[1]; ++j) {
+        const bool j_face = k_face || std::abs(j - bin[1]) == ring;
+        // Inside the shell only the two outermost bins of a row are on it
+        const int64_t step = j_face ? 1 : std::max<int64_t>(1, 2 * ring);
+        for (int64_t i = bin[0] - ring; i <= bin[0] + ring; i += step) {
+          if (i < lo[0] || i > hi[0]) {
+            continue;
+          }
+          const int64_t b = i + dims_[0] * (j + dims_[1] * k);
+          for (int64_t s = bin_start_[b]; s < bin_start_[b + 1]; ++s) {
+            const double* c = &sorted_centres_[3 * s];
+            const double dx = c[0] - p[0];
+            const double dy = c[1] - p[1];
+            const double dz = c[2] - p[2];
+            const double dist2 = dx * dx + dy * dy + dz * dz;
+            if (dist2 < *best_dist2 && accept(s)) {
+              *best_dist2 = dist2;
+              *best = s;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Read an ascii OpenFOAM list file. Fixed-size entries (n_per_entry
+  // numbers, e.g. 3 for points) go into `values`. With n_per_entry = 0, the
+  // entries are lists themselves (faces): their numbers go into `values`
+  // and the start of each entry into `offsets`.
+  template <typename T>
+  static bool ReadList(const std::string& file, int n_per_entry,
+                       std::vector<T>* values, std::vector<int64_t>* offsets,
+                       std::string* error) {
+    std::ifstream in(file);
+    if (!in) {
+      *error = "cannot open " + file;
+      return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    // Skip the FoamFile header
+    size_t pos = text.find("FoamFile");
+    if (pos != std::string::npos) {
+      const size_t header_end = text.find('}', pos);
+      if (text.substr(pos, header_end - pos).find("binary") != std::string::npos) {
+        *error = file + " is binary, only ascii meshes are supported";
+        return false;
+      }
+      pos = header_end + 1;
+    } else {
+      pos = 0;
+    }
+
+    const char* c = text.c_str() + pos;
+    const char* end = text.c_str() + text.size();
+    auto skip = [&]() {
+      while (c < end) {
+        if (std::isspace(static_cast<unsigned char>(*c))) {
+          ++c;
+        } else if (c + 1 < end && c[0] == '/' && c[1] == '/') {
+          while (c < end && *c != '\n') ++c;
+        } else if (c + 1 < end && c[0] == '/' && c[1] == '*') {
+          c += 2;
+          while (c + 1 < end && !(c[0] == '*' && c[1] == '/')) ++c;
+          c += 2;
+        } else {
+          break;
+        }
+      }
+    };
+    auto expect = [&](char token) {
+      skip();
+      if (c >= end || *c != token) {
+        return false;
+      }
+      ++c;
+      return true;
+    };
+    auto number = [&](double* x) {
+      skip();
+      char* next = nullptr;
+      *x = std::strtod(c, &next);
+      if (next == c) {
+        return false;
+      }
+      c = next;
+      return true;
+    };
+
+    double count = 0;
+    if (!number(&count) || !expect('(')) {
+      *error = "cannot parse " + file;
+      return false;
+    }
+    const int64_t n = count;
+    values->clear();
+    values->reserve(n * std::max(1, n_per_entry));
+    if (offsets != nullptr) {
+      offsets->assign(1, 0);
+      offsets->reserve(n + 1);
+    }
+
+    for (int64_t e = 0; e < n; ++e) {
+      int64_t entry_size = n_per_entry;
+      bool bracketed = n_per_entry > 1;
+      if (n_per_entry == 0) {
+        double size = 0;
+        if (!number(&size)) {
+          *error = "cannot parse " + file;
+          return false;
+        }
+        entry_size = size;
+        bracketed = true;
+      }
+      if (bracketed && !expect('(')) {
+        *error = "cannot parse " + file;
+        return false;
+      }
+      for (int64_t k = 0; k < entry_size; ++k) {
+        double x = 0;
+        if (!number(&x)) {
+          *error = "cannot parse " + file;
+          return false;
+        }
+        values->push_back(static_cast<T>(x));
+      }
+      if (bracketed && !expect(')')) {
+        *error = "cannot parse " + file;
+        return false;
+      }
+      if (offsets != nullptr) {
+        offsets->push_back(values->size());
+      }
+    }
+    if (!expect(')')) {
+      *error = "cannot parse " + file;
+      return false;
+    }
+    return true;
+  }
+
+  std::vector<double> centres_;         // Cell centres, by cell
+  std::vector<double> cell_bounds_;     // Cell bounding boxes, by cell
+  std::array<double, 6> bounds_ = {};   // Mesh bounding box
+  int64_t dims_[3] = {1, 1, 1};         // Number of bins per direction
+  double inv_bin_size_[3] = {0.0, 0.0, 0.0};
+  double min_bin_size_ = 0.0;
+  double max_cell_reach_ = 0.0;         // Largest centre-to-bounds distance
+  std::vector<int64_t> bin_start_;      // First sorted slot of each bin
+  std::vector<int64_t> sorted_cells_;   // Cell of each sorted slot
+  std::vector<double> sorted_centres_;  // Cell centres, bin by bin
+};
+
+}  // namespace bdm
+
+#endif  // CELL_LOCATOR_H_
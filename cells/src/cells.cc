@@ -13,6 +13,10 @@
 // -----------------------------------------------------------------------------
 #include "cells.h"
 
+namespace bdm {
+const ParamGroupUid CouplingParam::kUid = ParamGroupUidGenerator::Get()->NewUid();
+}  // namespace bdm
+
 // Use the namespace bdm to access the Simulate function defined in cells.h
 int main(int argc, const char** argv) { 
   // Call the Simulate function defined in cells.h
@@ -2,90 +2,80 @@
 #define CELLS_H_
 
 #include "biodynamo.h"
+#include "agent_seeding.h"
+#include "cell_locator.h"
+#include "coupling_log.h"
+#include "coupling_param.h"
+#include "coupling_snapshot.h"
+#include "phase_profiler.h"
 #include "precice_adapter.h"
 #include "my_cell.h"
 #include <algorithm>
-#include <map>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
 
 namespace bdm {
 
-inline int Simulate(int argc, const char** argv) {
-  Simulation simulation(argc, argv);
-  auto* rm = simulation.GetResourceManager();
-
-  // --- Create agents ---
-  Log::Info("Simulate", "Creating agents...");
-  
-  // Define OpenFOAM domain bounds for verification
-  const double domain_min_x = 0.0;
-  const double domain_max_x = 1.0;
-  const double domain_min_y = 0.0;
-  const double domain_max_y = 1.0;
-  const double domain_min_z = 0.0;
-  const double domain_max_z = 1.0;
-  
-  // OpenFOAM mesh details from blockMeshDict (50×50×50 cells)
-  const int openfoam_cells_per_dim = 50;
-  const double openfoam_cell_size = 1.0 / openfoam_cells_per_dim; // 0.02 units
-  
-  Log::Info("Simulate", "OpenFOAM domain: ", domain_min_x, "-", domain_max_x, " × ",
-            domain_min_y, "-", domain_max_y, " × ", domain_min_z, "-", domain_max_z);
-  Log::Info("Simulate", "OpenFOAM mesh: ", openfoam_cells_per_dim, "×", openfoam_cells_per_dim, 
-            "×", openfoam_cells_per_dim, " cells (cell size: ", openfoam_cell_size, ")");
-  
-  // BioDynaMo agent parameters
-  // We'll create agents exactly at OpenFOAM cell centers for better mapping
-  const int spacing = 5; // Use every 5th OpenFOAM cell
-  double cell_diameter = openfoam_cell_size * 0.5; // Cell diameter smaller than OF cell size
-  
-  // We'll still define an initial temperature as a fallback value
-  // But we'll read it from OpenFOAM when possible
-  double initial_temp = 300.0; // Default initial temperature if preCICE fails
-  
-  Log::Info("Simulate", "Creating BioDynaMo agents at OpenFOAM cell centers");
-  
-  int cell_count = 0;
-  std::map<int, MyCell*> of_cell_to_agent_map; // Maps OF cell indices to BDM agents
-  
-  // Create BioDynaMo agents at the centers of selected OpenFOAM cells
-  for (int i = 0; i < openfoam_cells_per_dim; i += spacing) {
-    for (int j = 0; j < openfoam_cells_per_dim; j += spacing) {
-      for (int k = 0; k < openfoam_cells_per_dim; k += spacing) {
-        // Calculate the exact center position of this OpenFOAM cell
-        double pos_x = (i + 0.5) * openfoam_cell_size;
-        double pos_y = (j + 0.5) * openfoam_cell_size;
-        double pos_z = (k + 0.5) * openfoam_cell_size;
-        
-        // Create a BioDynaMo agent (cell) at the exact center of this OpenFOAM cell
-        MyCell* cell = new MyCell({pos_x, pos_y, pos_z});
-        cell->SetDiameter(cell_diameter);
-        cell->SetTemperature(initial_temp); // Initially set to default value, will be updated with OpenFOAM data
-        
-        // Calculate the linear index of this OpenFOAM cell
-        int of_cell_index = i + j * openfoam_cells_per_dim + k * openfoam_cells_per_dim * openfoam_cells_per_dim;
-        
-        // Store in our mapping
-        of_cell_to_agent_map[of_cell_index] = cell;
-        
-        // Add the agent to the simulation
-        rm->AddAgent(cell);
-        
-        // Log cell creation (limit output)
-        if (cell_count < 5 || cell_count % 100 == 0) {
-          Log::Info("Simulate", "Created agent ", cell_count, 
-                   " at position (", pos_x, ", ", pos_y, ", ", pos_z, ")",
-                   " - OpenFOAM cell index: ", of_cell_index);
-        }
-        
-        cell_count++;
-      }
+// Create the agents of a new run, seeded by the rule of the coupling
+// parameters in the cells of the mesh (or of a cellSet of it), plus a few
+// test cells. The agents are created in parallel and added in batches.
+// Returns false if the cellSet cannot be read or the rule is invalid.
+inline bool CreateAgents(const CellLocator& locator,
+                         const std::string& poly_mesh_dir,
+                         const CouplingParam& coupling_param, uint64_t seed,
+                         double cell_diameter, double initial_temp) {
+  std::string error;
+  std::vector<int64_t> region;
+  if (!coupling_param.seed_cell_set.empty()) {
+    const std::string cell_set =
+        poly_mesh_dir + "/sets/" + coupling_param.seed_cell_set;
+    if (!CellLocator::ReadLabels(cell_set, &region, &error)) {
+      Log::Error("Simulate", "Cannot read the cellSet (", error,
+                 "). Run topoSet in ", coupling_param.openfoam_case,
+                 " first.");
+      return false;
     }
   }
-  
-  Log::Info("Simulate", "Created ", cell_count, " agents at centers of OpenFOAM volume cells");
-  
-  // Add special test cells at cardinal directions for debugging
-  Log::Info("Simulate", "------ Adding Cardinal Direction Test Cells ------");
+
+  SeedingRule rule;
+  rule.mode = coupling_param.seed_mode;
+  rule.lattice = coupling_param.seed_lattice;
+  rule.stride = coupling_param.seed_stride;
+  rule.density = coupling_param.seed_density;
+  rule.seed = seed;
+  std::vector<double> coords;
+  if (!SeedPositions(locator, region, rule, &coords, &error)) {
+    Log::Error("Simulate", "Cannot seed the agents (", error, ")");
+    return false;
+  }
+
+  const int64_t num_agents = coords.size() / 3;
+  std::vector<Real3> positions(num_agents);
+#pragma omp parallel for schedule(static)
+  for (int64_t a = 0; a < num_agents; ++a) {
+    positions[a] = {coords[3 * a], coords[3 * a + 1], coords[3 * a + 2]};
+  }
+
+  // Metabolic heat released by every agent into the fluid [W]
+  const double heat_release = 1e-3;
+
+  ModelInitializer::CreateAgents(positions, [&](const Real3& position) {
+    MyCell* cell = new MyCell(position);
+    cell->SetDiameter(cell_diameter);
+    // Updated with the OpenFOAM temperature once the coupling is initialized
+    cell->SetTemperature(initial_temp);
+    cell->SetHeatRelease(heat_release);
+    return cell;
+  });
+  Log::Info("Simulate", "Seeded ", num_agents, " agents (", rule.mode, ") in ",
+            coupling_param.seed_cell_set.empty()
+                ? "the OpenFOAM mesh"
+                : "the cellSet " + coupling_param.seed_cell_set);
+
+  // Test cells at cardinal directions for debugging, if inside the mesh
   const std::vector<std::pair<std::string, Real3>> testPoints = {
     {"Origin", {0.1, 0.1, 0.1}},
     {"X-axis", {0.9, 0.1, 0.1}},
@@ -94,44 +84,112 @@ inline int Simulate(int argc, const char** argv) {
     {"Center", {0.5, 0.5, 0.5}}
   };
 
+  auto* rm = Simulation::GetActive()->GetResourceManager();
   for (const auto& [name, pos] : testPoints) {
+    const double p[3] = {pos[0], pos[1], pos[2]};
+    if (locator.FindCell(p) < 0) {
+      Log::Warning("Simulate", "Test cell '", name, "' is outside of the OpenFOAM mesh, skipped");
+      continue;
+    }
     MyCell* cell = new MyCell(pos);
     cell->SetDiameter(cell_diameter);
     cell->SetTemperature(350.0); // Higher temperature to distinguish them
     rm->AddAgent(cell);
-    
-    Log::Info("Simulate", "Added test cell '", name, "' at position (", 
-              pos[0], ",", pos[1], ",", pos[2], ")");
   }
+  return true;
+}
+
+// Restore the agents of a snapshot, in vertex order
+inline void RestoreAgents(const CouplingSnapshot& snapshot,
+                          ResourceManager* rm) {
+  for (size_t i = 0; i < snapshot.GetNumAgents(); ++i) {
+    const double* position = &snapshot.positions[3 * i];
+    MyCell* cell = new MyCell({position[0], position[1], position[2]});
+    cell->SetDiameter(snapshot.diameters[i]);
+    cell->SetTemperature(snapshot.temperatures[i]);
+    cell->SetHeatRelease(snapshot.heat_releases[i]);
+    rm->AddAgent(cell);
+  }
+}
+
+inline int Simulate(int argc, const char** argv) {
+  Param::RegisterParamGroup(new CouplingParam());
+  Simulation simulation(argc, argv);
+  auto* rm = simulation.GetResourceManager();
+  const auto* param = simulation.GetParam();
+  const auto* coupling_param = param->Get<CouplingParam>();
+
+  // Messages of the coupling loop
+  CouplingLog::Level log_level = CouplingLog::kInfo;
+  if (!CouplingLog::ParseLevel(coupling_param->log_level, &log_level)) {
+    Log::Warning("Simulate", "Unknown log_level ", coupling_param->log_level,
+                 ", using info");
+  }
+  if (!CouplingLog::Get()->Configure(log_level, coupling_param->log_file,
+                                     coupling_param->log_async)) {
+    Log::Warning("Simulate", "Cannot open the log file ",
+                 coupling_param->log_file, ", logging to stdout");
+  }
+  const int log_every = std::max(1, coupling_param->log_every);
+
+  // --- Load the OpenFOAM mesh ---
+  // The cell locator maps positions to OpenFOAM cells, for any mesh
+  // (graded, snappy, ...). The mesh is written by blockMesh in the case.
+  const std::string poly_mesh_dir =
+      coupling_param->openfoam_case + "/constant/polyMesh";
+  CellLocator locator;
+  std::string mesh_error;
+  if (!locator.LoadPolyMesh(poly_mesh_dir, &mesh_error)) {
+    Log::Error("Simulate", "Cannot load the OpenFOAM mesh (", mesh_error,
+               "). Run blockMesh in ", coupling_param->openfoam_case,
+               " first.");
+    return 1;
+  }
+  const auto& domain = locator.GetBounds();
+  const double openfoam_cell_size =
+      std::cbrt((domain[1] - domain[0]) * (domain[3] - domain[2]) *
+                (domain[5] - domain[4]) / locator.GetNumCells());
+
+  Log::Info("Simulate", "OpenFOAM domain: ", domain[0], "-", domain[1], " × ",
+            domain[2], "-", domain[3], " × ", domain[4], "-", domain[5]);
+  Log::Info("Simulate", "OpenFOAM mesh: ", locator.GetNumCells(),
+            " cells (mean cell size: ", openfoam_cell_size, ")");
+
+  // --- Create agents ---
+  Log::Info("Simulate", "Creating agents...");
   
-  // Verify cells were created
-  uint64_t total_cells = rm->GetNumAgents();
-  Log::Info("Simulate", "Total agents in resource manager: ", total_cells);
-  
-  // Verify all cells are within domain
-  int cells_in_domain = 0;
-  int cells_outside_domain = 0;
+  double cell_diameter = openfoam_cell_size * 0.5; // Cell diameter smaller than OF cell size
   
-  rm->ForEachAgent([&](Agent* agent) {
-    if (auto* cell = dynamic_cast<MyCell*>(agent)) {
-      const auto& pos = cell->GetPosition();
-      bool in_domain = (pos[0] >= domain_min_x && pos[0] <= domain_max_x &&
-                       pos[1] >= domain_min_y && pos[1] <= domain_max_y &&
-                       pos[2] >= domain_min_z && pos[2] <= domain_max_z);
-      
-      if (in_domain) {
-        cells_in_domain++;
-      } else {
-        cells_outside_domain++;
-        Log::Warning("Simulate", "Cell at position (", pos[0], ",", pos[1], ",", pos[2], 
-                    ") is OUTSIDE OpenFOAM domain bounds!");
-      }
+  // We'll still define an initial temperature as a fallback value
+  // But we'll read it from OpenFOAM when possible
+  double initial_temp = 300.0; // Default initial temperature if preCICE fails
+
+  // Restart: the agents of the snapshot of restart_window, instead of new
+  // ones, together with their mapping to the OpenFOAM meshes
+  const int restart_window = coupling_param->restart_window;
+  CouplingSnapshot restart;
+  if (restart_window > 0) {
+    const std::string snapshot_file = CouplingSnapshotFile(
+        coupling_param->snapshot_dir, "cells", restart_window);
+    std::string snapshot_error;
+    if (!ReadCouplingSnapshot(snapshot_file, &restart, &snapshot_error)) {
+      Log::Error("Simulate", "Cannot restart (", snapshot_error, ")");
+      return 1;
     }
-  });
-  
-  Log::Info("Simulate", "Cell position verification - ", cells_in_domain, 
-           " cells INSIDE domain, ", cells_outside_domain, " cells OUTSIDE domain");
-  
+    RestoreAgents(restart, rm);
+    Log::Info("Simulate", "Restored ", restart.GetNumAgents(),
+              " agents of the snapshot of window ", restart_window,
+              " (t = ", restart.time, ")");
+  } else if (!CreateAgents(locator, poly_mesh_dir, *coupling_param,
+                           param->random_seed, cell_diameter, initial_temp)) {
+    return 1;
+  }
+
+  // The agents are seeded in the cells of the mesh, their positions need no
+  // check
+  uint64_t total_cells = rm->GetNumAgents();
+  Log::Info("Simulate", "Total agents in resource manager: ", total_cells);
+
   if (total_cells == 0) {
     Log::Error("Simulate", "ERROR: No cells were created! Stopping simulation.");
     return 1;
@@ -141,10 +199,49 @@ inline int Simulate(int argc, const char** argv) {
   // CRITICAL: Follow this exact order to avoid mesh modification errors
   
   // 1. Create preCICE adapter
-  Log::Info("Simulate", "Creating preCICE adapter...");
-  PreciceAdapter adapter("../precice-config.xml", "cells");
+  // With just-in-time mapping, the agents sample the OpenFOAM temperature at
+  // their current positions in every window, so they may move, divide and
+  // die. Otherwise, the temperature is mapped to the initial agent positions.
+  const bool just_in_time = coupling_param->just_in_time;
+  std::string precice_config = coupling_param->precice_config;
+  if (precice_config.empty()) {
+    precice_config =
+        just_in_time ? "../precice-config-jit.xml" : "../precice-config.xml";
+  }
+  const std::string& replay_file = coupling_param->replay_file;
+  if (replay_file.empty()) {
+    Log::Info("Simulate", "Creating preCICE adapter (", precice_config, ")...");
+  } else {
+    Log::Info("Simulate", "Creating adapter replaying ", replay_file, "...");
+  }
+  PreciceAdapter adapter(precice_config, "cells", just_in_time, replay_file);
+  adapter.SetAccessRegion(domain);
+  adapter.SetCellLocator(&locator);
+  adapter.SetHeatRelease(coupling_param->heat_release);
+
+  // Further fields of OpenFOAM, read together with the temperature
+  std::vector<FieldSpec> field_specs;
+  std::string fields_error;
+  if (!ParseFieldList(coupling_param->read_fields, &field_specs, &fields_error)) {
+    Log::Error("Simulate", "Invalid read_fields (", fields_error, ")");
+    return 1;
+  }
+  for (const auto& field : field_specs) {
+    if (!replay_file.empty() && field.name != "T") {
+      Log::Warning("Simulate", "A replay only provides T, ", field.name,
+                   " is not read");
+      continue;
+    }
+    adapter.AddReadField(field.name, field.components);
+  }
   
   // 2. Register agent positions with preCICE mesh BEFORE initialization
+  // (restart: with the OpenFOAM cells and heat targets of the snapshot)
+  if (restart_window > 0) {
+    adapter.RestoreMapping(std::move(restart.vertex_cells),
+                           std::move(restart.heat_targets),
+                           restart.received_hash);
+  }
   Log::Info("Simulate", "Registering agent positions with preCICE mesh...");
   adapter.UpdateMesh(simulation);
   
@@ -166,90 +263,21 @@ inline int Simulate(int argc, const char** argv) {
 
   // --- EXPLICIT AGENT TEMPERATURE INITIALIZATION FROM OPENFOAM ---
   Log::Info("Simulate", "Reading initial temperature data from OpenFOAM...");
-  std::vector<double> initial_temperatures;
-  adapter.ReadTemperature(initial_temperatures);
-
-  // Log temperature data status
-  if (!initial_temperatures.empty()) {
-    Log::Info("Simulate", "Successfully received ", initial_temperatures.size(), 
-              " initial temperature values from OpenFOAM (range: ", 
-              *std::min_element(initial_temperatures.begin(), initial_temperatures.end()), " to ",
-              *std::max_element(initial_temperatures.begin(), initial_temperatures.end()), ")");
-  } else {
-    Log::Warning("Simulate", "No initial temperature data received from OpenFOAM!");
-  }
-  
-  if (!initial_temperatures.empty()) {
-    Log::Info("Simulate", "Successfully received ", initial_temperatures.size(), 
+  if (adapter.ReadFields()) {
+    Log::Info("Simulate", "Successfully received ", adapter.GetFieldStore().GetNumVertices(),
               " initial temperature values from OpenFOAM");
-    
-    // Apply initial temperature values to cells - using agent UID to OpenFOAM cell mapping
-    const auto& cell_agent_map = adapter.GetCellAgentMap();
-    
-    if (!cell_agent_map.empty()) {
-      Log::Info("Simulate", "Using cell-agent mapping with ", cell_agent_map.size(), " entries");
-      
-      // Create map from AgentUid to temperature
-      std::map<AgentUid, double> agent_temperatures;
-      
-      for (size_t i = 0; i < cell_agent_map.size() && i < initial_temperatures.size(); i++) {
-        agent_temperatures[cell_agent_map[i].first] = initial_temperatures[i];
-      }
-      
-      // Track temperature stats
-      double min_init_temp = std::numeric_limits<double>::max();
-      double max_init_temp = std::numeric_limits<double>::lowest();
-      double sum_init_temp = 0.0;
-      int cells_initialized = 0;
-      
-      // Apply temperatures to agents
-      rm->ForEachAgent([&](Agent* agent) {
-        if (auto* cell = dynamic_cast<MyCell*>(agent)) {
-          auto agent_uid = cell->GetUid();
-          
-          // Check if this agent has a temperature mapping
-          auto it = agent_temperatures.find(agent_uid);
-          if (it != agent_temperatures.end()) {
-            double temp = it->second;
-            cell->SetTemperature(temp);
-            
-            // Track temperature stats
-            min_init_temp = std::min(min_init_temp, temp);
-            max_init_temp = std::max(max_init_temp, temp);
-            sum_init_temp += temp;
-            cells_initialized++;
-            
-            // Set color based on temperature (blue to red)
-            double norm_temp = (temp - 300.0) / 150.0; // Normalize to 0-1 range
-            Double3 color = {
-              std::min(1.0, std::max(0.0, norm_temp)),     // Red
-              0.0,                                         // Green
-              std::min(1.0, std::max(0.0, 1.0 - norm_temp)) // Blue
-            };
-            cell->SetCellColor(color);
-            
-            // Log a few examples
-            if (cells_initialized < 5 || cells_initialized % 200 == 0) {
-              const auto& pos = cell->GetPosition();
-              Log::Info("Simulate", "Cell at (", pos[0], ",", pos[1], ",", pos[2],
-                      ") initialized with temperature ", temp);
-            }
-          }
-        }
-      });
-      
-      // Log initialization statistics
-      if (cells_initialized > 0) {
-        double avg_temp = sum_init_temp / cells_initialized;
-        Log::Info("Simulate", "Successfully initialized ", cells_initialized, 
-                  " agent temperatures from OpenFOAM data");
-        Log::Info("Simulate", "Temperature stats - Min: ", min_init_temp, 
-                  ", Max: ", max_init_temp, ", Avg: ", avg_temp);
-      } else {
-        Log::Warning("Simulate", "No cells were initialized with temperature data");
-      }
+
+    // Map the initial temperatures to colors and compute their statistics
+    FieldStats stats = adapter.ApplyFields();
+
+    // Log initialization statistics
+    if (stats.count > 0) {
+      Log::Info("Simulate", "Successfully initialized ", stats.count,
+                " agent temperatures from OpenFOAM data");
+      Log::Info("Simulate", "Temperature stats - Min: ", stats.min,
+                ", Max: ", stats.max, ", Avg: ", stats.Mean());
     } else {
-      Log::Warning("Simulate", "Cell-agent mapping is empty!");
+      Log::Warning("Simulate", "No cells were initialized with temperature data");
     }
   } else {
     Log::Warning("Simulate", "Failed to receive initial temperature data from OpenFOAM. ",
@@ -260,133 +288,185 @@ inline int Simulate(int argc, const char** argv) {
   double dt = adapter.GetMaxTimeStep();
   Log::Info("Simulate", "Starting simulation with dt = ", dt);
   
-  int timestep = 0;
+  const bool export_agents =
+      param->export_visualization || param->insitu_visualization;
+
+  // Multi-rate coupling: `substeps` BioDynaMo steps per window, or one step
+  // every `windows_per_step` windows
+  const int substeps = std::max(1, coupling_param->substeps);
+  const int windows_per_step = std::max(1, coupling_param->windows_per_step);
+  const double expected_bdm_dt = dt * windows_per_step / substeps;
+  Log::Info("Simulate", "BioDynaMo runs ", substeps, " step(s) every ",
+            windows_per_step, " window(s)");
+  if (std::abs(param->simulation_time_step - expected_bdm_dt) >
+      0.01 * expected_bdm_dt) {
+    Log::Warning("Simulate", "simulation_time_step (", param->simulation_time_step,
+                 ") does not match the coupling rate (", expected_bdm_dt, ")");
+  }
+
+  // Latency of the phases of every window
+  PhaseProfiler profiler(coupling_param->profile);
+  const size_t kReadPhase = profiler.AddPhase("read_fields");
+  const size_t kApplyPhase = profiler.AddPhase("apply_fields");
+  const size_t kSyncPhase = profiler.AddPhase("sync_agents");
+  const size_t kSimulatePhase = profiler.AddPhase("simulate");
+  const size_t kWritePhase = profiler.AddPhase("write_heat_release");
+  const size_t kAdvancePhase = profiler.AddPhase("advance");
+
+  // A restart continues the counters of the snapshot; preCICE starts again
+  // at 0, `coupled_time` is the time of the whole run
+  int timestep = restart.timestep;
+  double coupled_time = restart.time;
+  FieldStats prev_stats;
+
+  // Log the statistics of the temperature of one read
+  auto log_temperature = [&](bool received, const FieldStats& stats) {
+    if (!received) {
+      COUPLING_LOG_EVERY_SECONDS(CouplingLog::kWarning, 10, "Timestep ",
+                                 timestep, ": no temperature data received");
+      return;
+    }
+    if (stats.count == 0) {
+      COUPLING_LOG_EVERY_SECONDS(CouplingLog::kWarning, 10, "Timestep ",
+                                 timestep,
+                                 ": no cells were updated with temperature data");
+      return;
+    }
+    COUPLING_LOG_EVERY_N(CouplingLog::kInfo, log_every, "Timestep ", timestep,
+                         ": temperature min ", stats.min, ", max ", stats.max,
+                         ", avg ", stats.Mean(), ", cells ", stats.count);
+    // The other fields (the magnitude of vector fields)
+    const auto& fields = adapter.GetReadFields();
+    for (size_t k = 1; k < fields.size(); ++k) {
+      const FieldStats& field_stats = adapter.GetFieldStats()[k];
+      COUPLING_LOG_EVERY_N(CouplingLog::kInfo, log_every, "Timestep ", timestep,
+                           ": ", adapter.GetFieldStore().GetFieldName(fields[k]),
+                           " min ", field_stats.min, ", max ", field_stats.max,
+                           ", avg ", field_stats.Mean());
+    }
+    // Change since the last read
+    if (timestep > 1) {
+      COUPLING_LOG(CouplingLog::kDebug, "Timestep ", timestep,
+                   ": temperature change min ", stats.min - prev_stats.min,
+                   ", max ", stats.max - prev_stats.max);
+    }
+    prev_stats = stats;
+  };
+
+  // Read the fields at a time within the current window, and log them
+  auto read_fields = [&](double relative_read_time) {
+    FieldStats stats;
+    bool received;
+    {
+      PhaseProfiler::Scope scope(&profiler, kReadPhase);
+      received = adapter.ReadFields(relative_read_time);
+    }
+    if (received) {
+      // Map the temperatures to colors and compute the statistics
+      PhaseProfiler::Scope scope(&profiler, kApplyPhase);
+      stats = adapter.ApplyFields();
+    }
+    log_temperature(received, stats);
+  };
+
+  // Snapshots of the agents, captured at the end of a window and written by
+  // a background thread
+  const int snapshot_every = std::max(0, coupling_param->snapshot_every);
+  std::unique_ptr<CouplingSnapshotWriter> snapshot_writer;
+  if (snapshot_every > 0) {
+    snapshot_writer.reset(
+        new CouplingSnapshotWriter(coupling_param->snapshot_dir, "cells"));
+    Log::Info("Simulate", "Writing a snapshot every ", snapshot_every,
+              " windows into ", coupling_param->snapshot_dir);
+  }
+  const size_t kSnapshotPhase = profiler.AddPhase("snapshot");
+  CouplingSnapshot snapshot;
+
+  int window = restart_window;
   while (adapter.IsCouplingOngoing()) {
-    timestep++;
-    Log::Info("Simulate", "Starting timestep ", timestep);
-    
-    // Read temperature data from preCICE
-    std::vector<double> temperatures;
-    adapter.ReadTemperature(temperatures);
-    
-    // Use direct console output to ensure visibility regardless of log level
-    if (!temperatures.empty()) {
-      std::cout << "TIMESTEP " << timestep << ": Received " << temperatures.size() 
-                << " temperature values" << std::endl;
-      
-      // Track temperature ranges
-      double min_temp = std::numeric_limits<double>::max();
-      double max_temp = std::numeric_limits<double>::lowest();
-      
-      for (size_t i = 0; i < temperatures.size(); i++) {
-        min_temp = std::min(min_temp, temperatures[i]);
-        max_temp = std::max(max_temp, temperatures[i]);
-      }
-      
-      std::cout << "TIMESTEP " << timestep << ": Temperature range [" 
-                << min_temp << ", " << max_temp << "]" << std::endl;
-      
-      // Check if values are changing between timesteps
-      static double prev_max_temp = 0;
-      static double prev_min_temp = 0;
-      
-      if (timestep > 1) {
-        std::cout << "TIMESTEP " << timestep << ": Temperature change: Min delta = " 
-                  << (min_temp - prev_min_temp) << ", Max delta = "
-                  << (max_temp - prev_max_temp) << std::endl;
-      }
-      
-      prev_min_temp = min_temp;
-      prev_max_temp = max_temp;
-      
-      // Apply temperature values to cells - using agent UID to OpenFOAM cell mapping
-      const auto& cell_agent_map = adapter.GetCellAgentMap();
-      
-      if (!cell_agent_map.empty()) {
-        // Create map from AgentUid to temperature
-        std::map<AgentUid, double> agent_temperatures;
-        
-        for (size_t i = 0; i < cell_agent_map.size() && i < temperatures.size(); i++) {
-          agent_temperatures[cell_agent_map[i].first] = temperatures[i];
+    window++;
+
+    // Skip the reads (and BioDynaMo) in the windows between two steps
+    if ((window - 1) % windows_per_step == 0) {
+      for (int substep = 0; substep < substeps; ++substep) {
+        timestep++;
+        COUPLING_LOG(CouplingLog::kDebug, "Starting timestep ", timestep);
+
+        // Sample the temperature at the current agent positions
+        if (just_in_time) {
+          adapter.UpdateMesh(simulation);
         }
-        
-        // Track temperature stats for agents
-        double min_applied_temp = std::numeric_limits<double>::max();
-        double max_applied_temp = std::numeric_limits<double>::lowest();
-        double sum_applied_temp = 0.0;
-        int cells_updated = 0;
-        
-        // Apply temperatures to agents
-        rm->ForEachAgent([&](Agent* agent) {
-          if (auto* cell = dynamic_cast<MyCell*>(agent)) {
-            auto agent_uid = cell->GetUid();
-            
-            // Check if this agent has a temperature mapping
-            auto it = agent_temperatures.find(agent_uid);
-            if (it != agent_temperatures.end()) {
-              double temp = it->second;
-              double old_temp = cell->GetTemperature();
-              cell->SetTemperature(temp);
-              
-              // Track temperature stats
-              min_applied_temp = std::min(min_applied_temp, temp);
-              max_applied_temp = std::max(max_applied_temp, temp);
-              sum_applied_temp += temp;
-              cells_updated++;
-              
-              // Set color based on temperature (blue to red)
-              double norm_temp = (temp - 300.0) / 150.0; // Normalize to 0-1 range
-              Double3 color = {
-                std::min(1.0, std::max(0.0, norm_temp)),     // Red
-                0.0,                                         // Green
-                std::min(1.0, std::max(0.0, 1.0 - norm_temp)) // Blue
-              };
-              cell->SetCellColor(color);
-              
-              // Only log a small sample of cells
-              if (cells_updated == 1 || cells_updated % 200 == 0) {
-                const auto& pos = cell->GetPosition();
-                std::cout << "TIMESTEP " << timestep << ": Cell at (" 
-                          << pos[0] << ", " << pos[1] << ", " << pos[2]
-                          << ") temperature changed from " << old_temp 
-                          << " to " << temp << " (delta: " 
-                          << temp - old_temp << ")" << std::endl;
-              }
-            }
-          }
-        });
-        
-        // Log temperature application statistics
-        if (cells_updated > 0) {
-          double avg_temp = sum_applied_temp / cells_updated;
-          std::cout << "TIMESTEP " << timestep << ": Temperature stats - Min: " 
-                    << min_applied_temp << ", Max: " << max_applied_temp
-                    << ", Avg: " << avg_temp << ", Cells updated: " 
-                    << cells_updated << std::endl;
-        } else {
-          std::cout << "TIMESTEP " << timestep << ": WARNING - No cells were updated with temperature data" << std::endl;
+
+        // Read the fields from preCICE, at the start of the substep
+        read_fields(substep * dt / substeps);
+
+        // The visualization exports the agent data members, copy the coupled
+        // values into them only if they are exported
+        if (export_agents) {
+          PhaseProfiler::Scope scope(&profiler, kSyncPhase);
+          adapter.SyncAgents();
         }
-      } else {
-        std::cout << "TIMESTEP " << timestep << ": WARNING - Cell-agent mapping is empty!" << std::endl;
+
+        // Run one simulation step
+        PhaseProfiler::Scope scope(&profiler, kSimulatePhase);
+        simulation.GetScheduler()->Simulate(1);
       }
-    } else {
-      std::cout << "TIMESTEP " << timestep << ": No temperature data received" << std::endl;
     }
     
-    // Run one simulation step
-    simulation.GetScheduler()->Simulate(1);
-    
+    // Deposit the heat released by the agents into the fluid cells
+    {
+      PhaseProfiler::Scope scope(&profiler, kWritePhase);
+      adapter.WriteHeatRelease();
+    }
+
     // Advance preCICE
-    Log::Info("Simulate", "Advancing preCICE with dt = ", dt);
-    adapter.Advance(dt);
-    
+    COUPLING_LOG(CouplingLog::kDebug, "Advancing preCICE with dt = ", dt);
+    {
+      PhaseProfiler::Scope scope(&profiler, kAdvancePhase);
+      adapter.Advance(dt);
+    }
+
+    coupled_time += dt;
+
+    if (snapshot_writer && window % snapshot_every == 0) {
+      PhaseProfiler::Scope scope(&profiler, kSnapshotPhase);
+      adapter.CaptureSnapshot(simulation, &snapshot);
+      snapshot.window = window;
+      snapshot.timestep = timestep;
+      snapshot.time = coupled_time;
+      std::string snapshot_error;
+      if (!snapshot_writer->Write(std::move(snapshot), &snapshot_error)) {
+        Log::Warning("Simulate", snapshot_error);
+      }
+    }
+
     double new_dt = adapter.GetMaxTimeStep();
-    Log::Info("Simulate", "Timestep ", timestep, " completed. New dt = ", new_dt);
+    COUPLING_LOG_EVERY_N(CouplingLog::kInfo, log_every, "Window ", window,
+                         " completed. New dt = ", new_dt);
     dt = new_dt;
   }
   
+  if (snapshot_writer) {
+    std::string snapshot_error;
+    if (!snapshot_writer->Wait(&snapshot_error)) {
+      Log::Warning("Simulate", snapshot_error);
+    }
+  }
+  CouplingLog::Get()->Close();
   Log::Info("Simulate", "Finalizing preCICE...");
   adapter.Finalize();
+
+  if (profiler.IsEnabled()) {
+    Log::Info("Simulate", "Coupling phases:\n", profiler.Report());
+    // The adapter traces use the MPI ranks as pids: use the process id
+    if (profiler.WriteTrace(coupling_param->trace_file, "cells", getpid())) {
+      Log::Info("Simulate", "Wrote the trace of the coupling phases to ",
+                coupling_param->trace_file);
+    } else {
+      Log::Warning("Simulate", "Cannot write the trace file ",
+                   coupling_param->trace_file);
+    }
+  }
   
   Log::Info("Simulate", "Simulation completed successfully after ", timestep, " timesteps");
   return 0;
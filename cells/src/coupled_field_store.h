@@ -0,0 +1,231 @@
+#ifndef COUPLED_FIELD_STORE_H_
+#define COUPLED_FIELD_STORE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bdm {
+
+// Statistics of a coupled scalar field (of the magnitude of a vector field)
+struct FieldStats {
+  double min = std::numeric_limits<double>::max();
+  double max = std::numeric_limits<double>::lowest();
+  double sum = 0.0;
+  uint64_t count = 0;
+
+  double Mean() const { return count > 0 ? sum / count : 0.0; }
+};
+
+// A field read from OpenFOAM: its preCICE data name and its number of
+// components (1: scalar, 3: vector)
+struct FieldSpec {
+  std::string name;
+  int components = 1;
+};
+
+// Parse a list of fields, separated by commas or spaces, e.g. "T, O2,
+// U:vector". A field is a scalar unless its name is followed by ":vector"
+// (or ":scalar"). Returns false (and sets `error`) if the list is invalid.
+inline bool ParseFieldList(const std::string& list,
+                           std::vector<FieldSpec>* fields,
+                           std::string* error) {
+  fields->clear();
+  std::string normalized = list;
+  std::replace(normalized.begin(), normalized.end(), ',', ' ');
+  std::istringstream in(normalized);
+  std::string entry;
+  while (in >> entry) {
+    FieldSpec field;
+    field.name = entry.substr(0, entry.find(':'));
+    if (entry.size() > field.name.size()) {
+      const std::string type = entry.substr(field.name.size() + 1);
+      if (type == "vector") {
+        field.components = 3;
+      } else if (type != "scalar") {
+        *error = "unknown type " + type + " of field " + field.name +
+                 " (scalar, vector)";
+        return false;
+      }
+    }
+    if (field.name.empty()) {
+      *error = "field without a name in \"" + list + "\"";
+      return false;
+    }
+    for (const auto& other : *fields) {
+      if (other.name == field.name) {
+        *error = "field " + field.name + " is listed twice";
+        return false;
+      }
+    }
+    fields->push_back(field);
+  }
+  return true;
+}
+
+// Coupled per-agent quantities, stored as contiguous arrays in preCICE vertex
+// order (struct of arrays) instead of inside the agents.
+// Every field has 1 (scalar) or more (vector) components per vertex. The
+// components are interleaved, which is the layout preCICE reads and writes,
+// so that readData() can write straight into Data(field).
+// The colors derived from a field are kept as three separate arrays.
+class CoupledFieldStore {
+ public:
+  // Add a field and return its index. Adding an existing field returns the
+  // index of the existing field.
+  size_t AddField(const std::string& name, int components) {
+    int existing = FindField(name);
+    if (existing >= 0) {
+      return existing;
+    }
+    names_.push_back(name);
+    components_.push_back(components);
+    data_.emplace_back(num_vertices_ * components, 0.0);
+    return names_.size() - 1;
+  }
+
+  // Index of a field, or -1 if there is no field with this name
+  int FindField(const std::string& name) const {
+    auto it = std::find(names_.begin(), names_.end(), name);
+    return it == names_.end() ? -1 : static_cast<int>(it - names_.begin());
+  }
+
+  // Set the number of vertices. Existing values are kept, new ones are 0.
+  void Resize(size_t num_vertices) {
+    num_vertices_ = num_vertices;
+    for (size_t f = 0; f < data_.size(); ++f) {
+      data_[f].resize(num_vertices * components_[f], 0.0);
+    }
+    red_.resize(num_vertices, 0.0);
+    green_.resize(num_vertices, 0.0);
+    blue_.resize(num_vertices, 1.0);
+  }
+
+  size_t GetNumVertices() const { return num_vertices_; }
+  size_t GetNumFields() const { return names_.size(); }
+  const std::string& GetFieldName(size_t field) const { return names_[field]; }
+  int GetComponents(size_t field) const { return components_[field]; }
+
+  // Interleaved values of a field (num_vertices * components entries)
+  double* Data(size_t field) { return data_[field].data(); }
+  const double* Data(size_t field) const { return data_[field].data(); }
+  size_t Size(size_t field) const { return data_[field].size(); }
+
+  // Component c of a field at one vertex
+  double Get(size_t field, size_t vertex, int c = 0) const {
+    return data_[field][vertex * components_[field] + c];
+  }
+
+  double GetRed(size_t vertex) const { return red_[vertex]; }
+  double GetGreen(size_t vertex) const { return green_[vertex]; }
+  double GetBlue(size_t vertex) const { return blue_[vertex]; }
+
+  // Min, max and sum of a scalar field over all vertices
+  FieldStats ScalarStats(size_t field) const {
+    FieldStats stats;
+    AddStats(field, 0, num_vertices_, &stats);
+    return stats;
+  }
+
+  // Map a scalar field to blue (at `low`) to red (at `high`) colors
+  void MapToColors(size_t field, double low, double high) {
+    MapToColors(field, low, high, 0, num_vertices_);
+  }
+
+  // Statistics of `fields` (stats[k] of fields[k], of the magnitude for
+  // vector fields) and the colors of the scalar field `color_field`, in one
+  // pass over the vertices. The vertices are visited in blocks that stay in
+  // the cache while all fields are processed, so adding a field adds its
+  // own array to the pass, not another pass.
+  void Apply(const std::vector<size_t>& fields, size_t color_field, double low,
+             double high, std::vector<FieldStats>* stats) {
+    stats->assign(fields.size(), FieldStats());
+    for (size_t begin = 0; begin < num_vertices_; begin += kBlockSize) {
+      const size_t end = std::min(begin + kBlockSize, num_vertices_);
+      for (size_t k = 0; k < fields.size(); ++k) {
+        AddStats(fields[k], begin, end, &(*stats)[k]);
+      }
+      MapToColors(color_field, low, high, begin, end);
+    }
+  }
+
+ private:
+  // Vertices of a block of Apply(): 2048 doubles per array (16 KiB)
+  static constexpr size_t kBlockSize = 2048;
+
+  // Add the values of the vertices [begin, end) of a field to `stats`
+  void AddStats(size_t field, size_t begin, size_t end,
+                FieldStats* stats) const {
+    const double* __restrict__ values = data_[field].data();
+    const int64_t b = begin;
+    const int64_t e = end;
+    double v_min = stats->min;
+    double v_max = stats->max;
+    double v_sum = stats->sum;
+
+    if (components_[field] == 1) {
+#pragma omp simd reduction(min : v_min) reduction(max : v_max) \
+    reduction(+ : v_sum)
+      for (int64_t i = b; i < e; ++i) {
+        v_min = std::min(v_min, values[i]);
+        v_max = std::max(v_max, values[i]);
+        v_sum += values[i];
+      }
+    } else {
+      const int64_t nc = components_[field];
+#pragma omp simd reduction(min : v_min) reduction(max : v_max) \
+    reduction(+ : v_sum)
+      for (int64_t i = b; i < e; ++i) {
+        double square = 0.0;
+        for (int64_t c = 0; c < nc; ++c) {
+          square += values[i * nc + c] * values[i * nc + c];
+        }
+        const double magnitude = std::sqrt(square);
+        v_min = std::min(v_min, magnitude);
+        v_max = std::max(v_max, magnitude);
+        v_sum += magnitude;
+      }
+    }
+
+    stats->min = v_min;
+    stats->max = v_max;
+    stats->sum = v_sum;
+    stats->count += end - begin;
+  }
+
+  void MapToColors(size_t field, double low, double high, size_t begin,
+                   size_t end) {
+    const double* __restrict__ values = data_[field].data();
+    double* __restrict__ red = red_.data();
+    double* __restrict__ green = green_.data();
+    double* __restrict__ blue = blue_.data();
+    const double scale = 1.0 / (high - low);
+    const int64_t b = begin;
+    const int64_t e = end;
+
+#pragma omp simd
+    for (int64_t i = b; i < e; ++i) {
+      const double norm = (values[i] - low) * scale;
+      red[i] = std::min(1.0, std::max(0.0, norm));
+      green[i] = 0.0;
+      blue[i] = std::min(1.0, std::max(0.0, 1.0 - norm));
+    }
+  }
+
+  size_t num_vertices_ = 0;
+  std::vector<std::string> names_;
+  std::vector<int> components_;
+  std::vector<std::vector<double>> data_;
+  std::vector<double> red_;
+  std::vector<double> green_;
+  std::vector<double> blue_;
+};
+
+}  // namespace bdm
+
+#endif  // COUPLED_FIELD_STORE_H_
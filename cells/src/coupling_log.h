@@ -0,0 +1,247 @@
+#ifndef COUPLING_LOG_H_
+#define COUPLING_LOG_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Most verbose level that is compiled (0: error ... 4: trace). Statements
+// above it are removed by the compiler.
+#ifndef COUPLING_LOG_MAX_LEVEL
+#define COUPLING_LOG_MAX_LEVEL 3
+#endif
+
+namespace bdm {
+
+// Leveled log of the messages of the coupling loop, which can be repeated in
+// thousands of windows:
+//
+//   COUPLING_LOG(CouplingLog::kDebug, "Advancing with dt = ", dt);
+//   COUPLING_LOG_EVERY_N(CouplingLog::kInfo, 100, "Window ", window);
+//   COUPLING_LOG_EVERY_SECONDS(CouplingLog::kWarning, 10, "...");
+//
+// The arguments of a statement are only evaluated and formatted if its level
+// is compiled in (COUPLING_LOG_MAX_LEVEL) and enabled at runtime
+// (CouplingParam::log_level). The lines are buffered and written without a
+// flush per line, by a background thread in the async mode. Setup messages
+// still use Log::Info.
+class CouplingLog {
+ public:
+  enum Level { kError = 0, kWarning, kInfo, kDebug, kTrace };
+
+  // State of one statement, for sampling and rate limiting
+  class Site {
+   public:
+    // True for the first of every n calls
+    bool Sample(uint64_t n) { return n <= 1 || count_++ % n == 0; }
+
+    // True if the last accepted call is at least `seconds` ago
+    bool Limit(double seconds) {
+      const auto now = std::chrono::steady_clock::now();
+      if (logged_ &&
+          std::chrono::duration<double>(now - last_).count() < seconds) {
+        ++count_;
+        return false;
+      }
+      skipped_ = logged_ ? count_ : 0;
+      count_ = 0;
+      last_ = now;
+      logged_ = true;
+      return true;
+    }
+
+    // Note on the calls rejected by Limit() before the last accepted one
+    std::string SkippedNote() const {
+      return skipped_ > 0 ? " (" + std::to_string(skipped_) +
+                                " similar messages skipped)"
+                          : std::string();
+    }
+
+   private:
+    uint64_t count_ = 0;
+    uint64_t skipped_ = 0;
+    std::chrono::steady_clock::time_point last_;
+    bool logged_ = false;
+  };
+
+  static CouplingLog* Get() {
+    static CouplingLog log;
+    return &log;
+  }
+
+  static bool IsEnabled(int level) {
+    return level <= level_.load(std::memory_order_relaxed);
+  }
+
+  static const char* GetLevelName(int level) {
+    static const char* names[] = {"error", "warning", "info", "debug",
+                                  "trace"};
+    return names[std::clamp(level, 0, 4)];
+  }
+
+  // Level from its name (error, warning, info, debug, trace)
+  static bool ParseLevel(const std::string& name, Level* level) {
+    for (int l = kError; l <= kTrace; ++l) {
+      if (name == GetLevelName(l)) {
+        *level = static_cast<Level>(l);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  ~CouplingLog() { Close(); }
+
+  CouplingLog(const CouplingLog&) = delete;
+  CouplingLog& operator=(const CouplingLog&) = delete;
+
+  // Set the runtime level and the sink. An empty `file_name` writes to
+  // stdout. Returns false if the file cannot be opened (then stdout).
+  bool Configure(Level level, const std::string& file_name, bool async) {
+    Close();
+    level_ = level;
+    bool opened = true;
+    if (!file_name.empty()) {
+      file_ = std::fopen(file_name.c_str(), "w");
+      if (file_ == nullptr) {
+        file_ = stdout;
+        opened = false;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    async_ = async;
+    stop_ = false;
+    if (async_) {
+      worker_ = std::thread(&CouplingLog::Run, this);
+    }
+    return opened;
+  }
+
+  template <typename... Args>
+  void Write(int level, const Args&... parts) {
+    std::ostringstream line;
+    line << '[' << GetLevelName(level) << "] ";
+    (line << ... << parts);
+    line << '\n';
+
+    bool full;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      buffer_ += line.str();
+      full = buffer_.size() >= kFlushSize;
+    }
+    if (full) {
+      if (async_) {
+        wake_up_.notify_one();
+      } else {
+        Drain();
+      }
+    }
+  }
+
+  // Write the buffer now
+  void Flush() { Drain(); }
+
+  // Flush, stop the background thread and close the file
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_up_.notify_one();
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    Drain();
+    if (file_ != stdout) {
+      std::fclose(file_);
+      file_ = stdout;
+    }
+  }
+
+ private:
+  static constexpr size_t kFlushSize = 1 << 16;
+
+  static inline std::atomic<int> level_{kInfo};
+
+  CouplingLog() = default;
+
+  // Write and empty the buffer. One thread writes at a time, so that the
+  // lines stay in order, and the simulation can keep logging meanwhile.
+  void Drain() {
+    std::lock_guard<std::mutex> file_lock(file_mutex_);
+    std::string lines;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      lines.swap(buffer_);
+    }
+    if (!lines.empty()) {
+      std::fwrite(lines.data(), 1, lines.size(), file_);
+      std::fflush(file_);
+    }
+  }
+
+  // Background thread: write at least every half second
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      wake_up_.wait_for(lock, std::chrono::milliseconds(500));
+      lock.unlock();
+      Drain();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;       // Guards the buffer
+  std::mutex file_mutex_;  // Guards the writing of the file
+  std::condition_variable wake_up_;
+  std::thread worker_;
+  std::string buffer_;
+  std::FILE* file_ = stdout;
+  bool async_ = false;
+  bool stop_ = false;
+};
+
+}  // namespace bdm
+
+#define COUPLING_LOG_ON(level) \
+  ((level) <= COUPLING_LOG_MAX_LEVEL && ::bdm::CouplingLog::IsEnabled(level))
+
+#define COUPLING_LOG(level, ...)                             \
+  do {                                                       \
+    if (COUPLING_LOG_ON(level)) {                            \
+      ::bdm::CouplingLog::Get()->Write(level, __VA_ARGS__);  \
+    }                                                        \
+  } while (false)
+
+// Log the first of every n executions of this statement
+#define COUPLING_LOG_EVERY_N(level, n, ...)                    \
+  do {                                                         \
+    if (COUPLING_LOG_ON(level)) {                              \
+      static ::bdm::CouplingLog::Site coupling_log_site;       \
+      if (coupling_log_site.Sample(n)) {                       \
+        ::bdm::CouplingLog::Get()->Write(level, __VA_ARGS__);  \
+      }                                                        \
+    }                                                          \
+  } while (false)
+
+// Log this statement at most once every `seconds`
+#define COUPLING_LOG_EVERY_SECONDS(level, seconds, ...)                     \
+  do {                                                                      \
+    if (COUPLING_LOG_ON(level)) {                                           \
+      static ::bdm::CouplingLog::Site coupling_log_site;                    \
+      if (coupling_log_site.Limit(seconds)) {                               \
+        ::bdm::CouplingLog::Get()->Write(level, __VA_ARGS__,                \
+                                         coupling_log_site.SkippedNote());  \
+      }                                                                     \
+    }                                                                       \
+  } while (false)
+
+#endif  // COUPLING_LOG_H_
@@ -0,0 +1,95 @@
+#ifndef COUPLING_PARAM_H_
+#define COUPLING_PARAM_H_
+
+#include <string>
+#include "biodynamo.h"
+
+namespace bdm {
+
+// Parameters of the coupling with OpenFOAM, set in bdm.json:
+//   { "bdm::CouplingParam": { "substeps": 4 } }
+// BioDynaMo runs `substeps` steps in every preCICE window, or one step every
+// `windows_per_step` windows. The BioDynaMo time step (simulation_time_step)
+// should match: window / substeps, or window * windows_per_step.
+struct CouplingParam : public ParamGroup {
+  BDM_PARAM_GROUP_HEADER(CouplingParam, 1);
+
+  // Number of BioDynaMo steps per preCICE window. The temperature of every
+  // substep is interpolated in time (waveform) within the window.
+  int substeps = 1;
+
+  // Number of preCICE windows per BioDynaMo step. The temperature is only
+  // read in the windows in which BioDynaMo steps.
+  int windows_per_step = 1;
+
+  // Sample the OpenFOAM temperature at the current agent positions in every
+  // window (just-in-time mapping, ../precice-config-jit.xml), instead of at
+  // the initial agent positions (../precice-config.xml). Just-in-time mapping
+  // is experimental in preCICE v3 (experimental="true" in the configuration).
+  bool just_in_time = false;
+
+  // preCICE configuration file. Empty: ../precice-config.xml, or
+  // ../precice-config-jit.xml for just-in-time mapping. Use
+  // ../precice-config-parallel.xml for the parallel-explicit scheme, which
+  // overlaps the OpenFOAM and BioDynaMo steps; the agents then see the
+  // temperature of the previous window.
+  std::string precice_config = "";
+
+  // OpenFOAM case whose mesh (constant/polyMesh, and its cellSets) maps the
+  // agent positions to cells. Must be the case that the adapter runs on.
+  std::string openfoam_case = "../cavity_temp";
+
+  // Fields read from OpenFOAM in every read, e.g. "T, O2, U:vector"
+  // (coupled_field_store.h). The temperature T is always read. Every field
+  // must be a data of the coupling mesh in the preCICE configuration. A
+  // replay only provides T.
+  std::string read_fields = "T";
+
+  // Deposit the heat released by the agents into the fluid (data Q on the
+  // received VolumeMesh). Set to false for ../precice-config-direct-access.xml,
+  // which only exchanges T on the CellMesh.
+  bool heat_release = true;
+
+  // Replay the temperature recorded by the OpenFOAM adapter (FP option
+  // recordFile) instead of coupling through preCICE. Empty: couple.
+  std::string replay_file = "";
+
+  // Time every phase of the coupling loop (read, apply, simulate, write,
+  // advance): log their percentiles at the end and write them to
+  // `trace_file` (Chrome trace format, open in https://ui.perfetto.dev
+  // together with the preCICE and adapter traces)
+  bool profile = false;
+  std::string trace_file = "cells-trace.json";
+
+  // Messages of the coupling loop (coupling_log.h): level (error, warning,
+  // info, debug, trace), written every `log_every` windows, into `log_file`
+  // (empty: stdout) by a background thread if `log_async`
+  std::string log_level = "info";
+  int log_every = 1;
+  std::string log_file = "";
+  bool log_async = true;
+
+  // Seeding of the agents of a new run (agent_seeding.h), in the cells of
+  // the OpenFOAM mesh or of its cellSet `seed_cell_set` (written by topoSet
+  // into constant/polyMesh/sets). `seed_mode`: lattice (`seed_lattice`
+  // points per direction), cells (every `seed_stride`-th cell) or density
+  // (`seed_density` agents per unit volume, random positions).
+  std::string seed_cell_set = "";
+  std::string seed_mode = "lattice";
+  int seed_lattice = 10;
+  int seed_stride = 1;
+  double seed_density = 0.0;
+
+  // Snapshot of the agents every `snapshot_every` windows (0: none), written
+  // into `snapshot_dir` by a background thread. With `restart_window`, the
+  // agents are restored from the snapshot of that window instead of being
+  // created (see ../restart.sh, which restarts both participants from the
+  // latest window that both have a snapshot of).
+  int snapshot_every = 0;
+  std::string snapshot_dir = "../snapshots";
+  int restart_window = 0;
+};
+
+}  // namespace bdm
+
+#endif  // COUPLING_PARAM_H_
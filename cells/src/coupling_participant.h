@@ -0,0 +1,215 @@
+#ifndef COUPLING_PARTICIPANT_H_
+#define COUPLING_PARTICIPANT_H_
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "biodynamo.h"
+#include "cell_locator.h"
+#include "precice/precice.hpp"
+#include "record_file.h"
+
+namespace bdm {
+
+// The part of the preCICE participant API that the PreciceAdapter uses, so
+// that the coupling can also be driven without OpenFOAM (ReplayParticipant).
+class CouplingParticipant {
+ public:
+  virtual ~CouplingParticipant() = default;
+
+  virtual void SetMeshAccessRegion(const std::string& mesh,
+                                   precice::span<const double> bounding_box) = 0;
+  virtual void Initialize() = 0;
+  virtual void SetMeshVertices(const std::string& mesh,
+                               precice::span<const double> coordinates,
+                               precice::span<int> ids) = 0;
+  virtual int GetMeshVertexSize(const std::string& mesh) = 0;
+  virtual void GetMeshVertexIDsAndCoordinates(const std::string& mesh,
+                                              precice::span<int> ids,
+                                              precice::span<double> coordinates) = 0;
+  virtual void ReadData(const std::string& mesh, const std::string& data,
+                        precice::span<const int> ids, double relative_read_time,
+                        precice::span<double> values) = 0;
+  virtual void MapAndReadData(const std::string& mesh, const std::string& data,
+                              precice::span<const double> coordinates,
+                              double relative_read_time,
+                              precice::span<double> values) = 0;
+  virtual void WriteData(const std::string& mesh, const std::string& data,
+                         precice::span<const int> ids,
+                         precice::span<const double> values) = 0;
+  virtual bool RequiresInitialData() = 0;
+  virtual void Advance(double dt) = 0;
+  virtual bool IsCouplingOngoing() = 0;
+  virtual double GetMaxTimeStepSize() = 0;
+  virtual void Finalize() = 0;
+};
+
+// Coupling through preCICE. The agents run in one process (rank 0 of 1),
+// also when OpenFOAM runs decomposed: preCICE connects the ranks of both
+// participants, and the received VolumeMesh covers all the fluid ranks.
+class PreciceParticipant : public CouplingParticipant {
+ public:
+  PreciceParticipant(const std::string& participant_name,
+                     const std::string& config_file)
+      : participant_(participant_name, config_file, 0, 1) {}
+
+  void SetMeshAccessRegion(const std::string& mesh,
+                           precice::span<const double> bounding_box) override {
+    participant_.setMeshAccessRegion(mesh, bounding_box);
+  }
+  void Initialize() override { participant_.initialize(); }
+  void SetMeshVertices(const std::string& mesh,
+                       precice::span<const double> coordinates,
+                       precice::span<int> ids) override {
+    participant_.setMeshVertices(mesh, coordinates, ids);
+  }
+  int GetMeshVertexSize(const std::string& mesh) override {
+    return participant_.getMeshVertexSize(mesh);
+  }
+  void GetMeshVertexIDsAndCoordinates(const std::string& mesh,
+                                      precice::span<int> ids,
+                                      precice::span<double> coordinates) override {
+    participant_.getMeshVertexIDsAndCoordinates(mesh, ids, coordinates);
+  }
+  void ReadData(const std::string& mesh, const std::string& data,
+                precice::span<const int> ids, double relative_read_time,
+                precice::span<double> values) override {
+    participant_.readData(mesh, data, ids, relative_read_time, values);
+  }
+  void MapAndReadData(const std::string& mesh, const std::string& data,
+                      precice::span<const double> coordinates,
+                      double relative_read_time,
+                      precice::span<double> values) override {
+    participant_.mapAndReadData(mesh, data, coordinates, relative_read_time,
+                                values);
+  }
+  void WriteData(const std::string& mesh, const std::string& data,
+                 precice::span<const int> ids,
+                 precice::span<const double> values) override {
+    participant_.writeData(mesh, data, ids, values);
+  }
+  bool RequiresInitialData() override {
+    return participant_.requiresInitialData();
+  }
+  void Advance(double dt) override { participant_.advance(dt); }
+  bool IsCouplingOngoing() override {
+    return participant_.isCouplingOngoing();
+  }
+  double GetMaxTimeStepSize() override {
+    return participant_.getMaxTimeStepSize();
+  }
+  void Finalize() override { participant_.finalize(); }
+
+ private:
+  precice::Participant participant_;
+};
+
+// Replays a temperature record of OpenFOAM (RecordFile) instead of coupling.
+// The recorded vertices play the role of the received VolumeMesh. Vertices
+// of our own meshes and mapAndReadData() coordinates read the value of the
+// nearest recorded vertex. The temperature is interpolated linearly in time
+// between the records, like the preCICE waveform of degree 1. Written data
+// is dropped. The coupling ends after the last record.
+class ReplayParticipant : public CouplingParticipant {
+ public:
+  explicit ReplayParticipant(const std::string& record_file) {
+    std::string error;
+    if (!record_.Open(record_file, &error)) {
+      Log::Fatal("ReplayParticipant", "Cannot replay: ", error);
+    }
+    if (record_.GetNumRecords() == 0) {
+      Log::Fatal("ReplayParticipant", record_file, " contains no records");
+    }
+    recorded_.SetCellCentres(record_.GetCoordinates(), record_.GetNumVertices());
+    Log::Info("ReplayParticipant", "Replaying ", record_.GetNumRecords(),
+              " records of ", record_.GetNumVertices(), " vertices from ",
+              record_file, ", t = ", record_.GetTime(0), " .. ",
+              record_.GetTime(record_.GetNumRecords() - 1));
+  }
+
+  void SetMeshAccessRegion(const std::string&,
+                           precice::span<const double>) override {}
+  void Initialize() override { time_ = 0.0; }
+
+  void SetMeshVertices(const std::string& mesh,
+                       precice::span<const double> coordinates,
+                       precice::span<int> ids) override {
+    auto& nearest = nearest_[mesh];
+    const size_t offset = nearest.size();
+    const size_t n = coordinates.size() / 3;
+    nearest.resize(offset + n);
+    recorded_.FindNearestCells(coordinates.data(), n, &nearest[offset]);
+    for (size_t i = 0; i < n; ++i) {
+      ids[i] = offset + i;
+    }
+  }
+
+  // Any mesh without own vertices is the recorded one
+  int GetMeshVertexSize(const std::string&) override {
+    return record_.GetNumVertices();
+  }
+  void GetMeshVertexIDsAndCoordinates(const std::string&,
+                                      precice::span<int> ids,
+                                      precice::span<double> coordinates) override {
+    for (size_t i = 0; i < ids.size(); ++i) {
+      ids[i] = i;
+    }
+    std::copy(record_.GetCoordinates(),
+              record_.GetCoordinates() + coordinates.size(), coordinates.data());
+  }
+
+  void ReadData(const std::string& mesh, const std::string&,
+                precice::span<const int> ids, double relative_read_time,
+                precice::span<double> values) override {
+    auto it = nearest_.find(mesh);
+    vertices_.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      vertices_[i] = it != nearest_.end() ? it->second[ids[i]] : ids[i];
+    }
+    record_.Sample(time_ + relative_read_time, vertices_.data(),
+                   vertices_.size(), values.data());
+  }
+
+  void MapAndReadData(const std::string&, const std::string&,
+                      precice::span<const double> coordinates,
+                      double relative_read_time,
+                      precice::span<double> values) override {
+    vertices_.resize(coordinates.size() / 3);
+    recorded_.FindNearestCells(coordinates.data(), vertices_.size(),
+                               vertices_.data());
+    record_.Sample(time_ + relative_read_time, vertices_.data(),
+                   vertices_.size(), values.data());
+  }
+
+  void WriteData(const std::string&, const std::string&,
+                 precice::span<const int>,
+                 precice::span<const double>) override {}
+
+  bool RequiresInitialData() override { return false; }
+  void Advance(double dt) override { time_ += dt; }
+
+  bool IsCouplingOngoing() override {
+    return time_ < EndTime() - 1e-9 * record_.GetWindowSize();
+  }
+  double GetMaxTimeStepSize() override {
+    return std::min(record_.GetWindowSize(), EndTime() - time_);
+  }
+  void Finalize() override {}
+
+ private:
+  double EndTime() const {
+    return record_.GetTime(record_.GetNumRecords() - 1);
+  }
+
+  RecordFile record_;
+  CellLocator recorded_;  // Index of the recorded vertices
+  std::map<std::string, std::vector<int64_t>> nearest_;  // Per own mesh
+  std::vector<int64_t> vertices_;  // Recorded vertex of every read value
+  double time_ = 0.0;
+};
+
+}  // namespace bdm
+
+#endif  // COUPLING_PARTICIPANT_H_
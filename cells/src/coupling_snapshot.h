@@ -0,0 +1,212 @@
+#ifndef COUPLING_SNAPSHOT_H_
+#define COUPLING_SNAPSHOT_H_
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bdm {
+
+// State of the cells participant at the end of a coupling window, to restart
+// the coupled run from it: the agents in vertex order and their mapping to
+// the OpenFOAM meshes, so that a restart in mesh mode does not search the
+// cells and received vertices again.
+struct CouplingSnapshot {
+  uint64_t window = 0;
+  uint64_t timestep = 0;  // BioDynaMo steps
+  double time = 0;        // Coupled time at the end of the window
+  // Hash of the coordinates of the received mesh that heat_targets refer to
+  uint64_t received_hash = 0;
+
+  // Per agent, in vertex order
+  std::vector<double> positions;  // 3 per agent
+  std::vector<double> diameters;
+  std::vector<double> temperatures;
+  std::vector<double> heat_releases;
+  // OpenFOAM cell and received vertex of each agent. Empty if not mapped
+  // (just-in-time mapping maps the agents in every window).
+  std::vector<int64_t> vertex_cells;
+  std::vector<int64_t> heat_targets;
+
+  size_t GetNumAgents() const { return diameters.size(); }
+};
+
+// Header of a snapshot file (native byte order), followed by the arrays of
+// the snapshot in the order of its members
+struct CouplingSnapshotHeader {
+  char magic[8];  // "BDMSNP01"
+  uint64_t window;
+  uint64_t timestep;
+  double time;
+  uint64_t received_hash;
+  uint64_t num_agents;
+  uint64_t num_vertex_cells;
+  uint64_t num_heat_targets;
+};
+static_assert(sizeof(CouplingSnapshotHeader) == 64,
+              "Unexpected CouplingSnapshotHeader padding");
+
+// FNV-1a hash of an array of values, to recognize a received mesh
+inline uint64_t HashValues(const double* values, size_t n) {
+  uint64_t hash = 1469598103934665603ull;
+  const auto* bytes = reinterpret_cast<const unsigned char*>(values);
+  for (size_t i = 0; i < n * sizeof(double); ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+// File of the snapshot of a window. The OpenFOAM adapter names its
+// snapshots the same way (with the participant name of its preciceDict).
+inline std::string CouplingSnapshotFile(const std::string& dir,
+                                        const std::string& participant,
+                                        uint64_t window) {
+  return dir + "/" + participant + "-" + std::to_string(window) + ".snap";
+}
+
+// Write a snapshot. The file is written under a temporary name and renamed
+// once it is complete, so that an interrupted run leaves no partial
+// snapshot. Returns false (and sets `error`) if it cannot be written.
+inline bool WriteCouplingSnapshot(const std::string& file_name,
+                                  const CouplingSnapshot& snapshot,
+                                  std::string* error) {
+  CouplingSnapshotHeader header;
+  std::memcpy(header.magic, "BDMSNP01", sizeof(header.magic));
+  header.window = snapshot.window;
+  header.timestep = snapshot.timestep;
+  header.time = snapshot.time;
+  header.received_hash = snapshot.received_hash;
+  header.num_agents = snapshot.GetNumAgents();
+  header.num_vertex_cells = snapshot.vertex_cells.size();
+  header.num_heat_targets = snapshot.heat_targets.size();
+
+  const std::string partial = file_name + ".tmp";
+  std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+  auto write = [&](const auto& values) {
+    out.write(reinterpret_cast<const char*>(values.data()),
+              values.size() * sizeof(values[0]));
+  };
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write(snapshot.positions);
+  write(snapshot.diameters);
+  write(snapshot.temperatures);
+  write(snapshot.heat_releases);
+  write(snapshot.vertex_cells);
+  write(snapshot.heat_targets);
+  out.close();
+
+  if (!out || std::rename(partial.c_str(), file_name.c_str()) != 0) {
+    std::remove(partial.c_str());
+    *error = "cannot write " + file_name;
+    return false;
+  }
+  return true;
+}
+
+// Read a snapshot. Returns false (and sets `error`) if the file cannot be
+// read or is not a complete snapshot.
+inline bool ReadCouplingSnapshot(const std::string& file_name,
+                                 CouplingSnapshot* snapshot,
+                                 std::string* error) {
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in) {
+    *error = "cannot open " + file_name;
+    return false;
+  }
+  CouplingSnapshotHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, "BDMSNP01", sizeof(header.magic)) != 0) {
+    *error = file_name + " is not a snapshot of the cells participant";
+    return false;
+  }
+  snapshot->window = header.window;
+  snapshot->timestep = header.timestep;
+  snapshot->time = header.time;
+  snapshot->received_hash = header.received_hash;
+
+  const uint64_t n = header.num_agents;
+  snapshot->positions.resize(3 * n);
+  snapshot->diameters.resize(n);
+  snapshot->temperatures.resize(n);
+  snapshot->heat_releases.resize(n);
+  snapshot->vertex_cells.resize(header.num_vertex_cells);
+  snapshot->heat_targets.resize(header.num_heat_targets);
+  auto read = [&](auto& values) {
+    in.read(reinterpret_cast<char*>(values.data()),
+            values.size() * sizeof(values[0]));
+  };
+  read(snapshot->positions);
+  read(snapshot->diameters);
+  read(snapshot->temperatures);
+  read(snapshot->heat_releases);
+  read(snapshot->vertex_cells);
+  read(snapshot->heat_targets);
+  if (!in) {
+    *error = file_name + " is incomplete";
+    return false;
+  }
+  return true;
+}
+
+// Writes the snapshots on a background thread, so that the coupling loop
+// only pays for capturing them. One snapshot is written at a time: Write()
+// waits for the previous one.
+class CouplingSnapshotWriter {
+ public:
+  // Snapshots are written into `dir` (created if needed)
+  CouplingSnapshotWriter(const std::string& dir, const std::string& participant)
+      : dir_(dir), participant_(participant) {
+    mkdir(dir_.c_str(), 0755);
+  }
+
+  ~CouplingSnapshotWriter() { Wait(nullptr); }
+
+  CouplingSnapshotWriter(const CouplingSnapshotWriter&) = delete;
+  CouplingSnapshotWriter& operator=(const CouplingSnapshotWriter&) = delete;
+
+  // Write a snapshot in the background. Returns false (and sets `error`) if
+  // the previous one could not be written.
+  bool Write(CouplingSnapshot&& snapshot, std::string* error) {
+    const bool written = Wait(error);
+    snapshot_ = std::move(snapshot);
+    const std::string file_name =
+        CouplingSnapshotFile(dir_, participant_, snapshot_.window);
+    worker_ = std::thread([this, file_name]() {
+      ok_ = WriteCouplingSnapshot(file_name, snapshot_, &error_);
+    });
+    return written;
+  }
+
+  // Wait for the background write. Returns false (and sets `error`, if not
+  // null) if it failed.
+  bool Wait(std::string* error) {
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    const bool ok = ok_;
+    if (!ok && error != nullptr) {
+      *error = error_;
+    }
+    ok_ = true;
+    return ok;
+  }
+
+ private:
+  std::string dir_;
+  std::string participant_;
+  CouplingSnapshot snapshot_;  // Read by the worker until it is joined
+  std::thread worker_;
+  bool ok_ = true;
+  std::string error_;
+};
+
+}  // namespace bdm
+
+#endif  // COUPLING_SNAPSHOT_H_
@@ -2,9 +2,24 @@
 #define MY_CELL_H_
 
 #include "biodynamo.h"
+#include <algorithm>
+
+#include "coupled_field_store.h"
 
 namespace bdm {
 
+// Coupled field store that the MyCell accessors read from. It is attached by
+// the PreciceAdapter, which owns the store.
+struct CoupledFieldView {
+  const CoupledFieldStore* store = nullptr;
+  size_t temperature = 0;  // Field index of the temperature
+};
+
+inline CoupledFieldView& GetCoupledFieldView() {
+  static CoupledFieldView view;
+  return view;
+}
+
 // Define a custom cell type MyCell that inherits from bdm::Cell
 class MyCell : public Cell {
   BDM_AGENT_HEADER(MyCell, Cell, 1); // Macro needed for BioDynaMo's agent system
@@ -12,24 +27,79 @@ class MyCell : public Cell {
  private: // Keep internal data private
   double temperature_ = 0.0; // Initialize temperature, default to 0 or an expected initial value
   Double3 cell_color_ = {0.0, 0.0, 1.0}; // Default blue color (RGB), needed for visualization
+  double heat_release_ = 0.0; // Metabolic heat release rate [W], deposited into the fluid
+  int64_t vertex_index_ = -1; // preCICE vertex of this cell, -1 if not coupled
+
+  // Attached store if it holds the values of this cell, nullptr otherwise
+  const CoupledFieldStore* CoupledStore() const {
+    const auto* store = GetCoupledFieldView().store;
+    if (store == nullptr || vertex_index_ < 0 ||
+        static_cast<size_t>(vertex_index_) >= store->GetNumVertices()) {
+      return nullptr;
+    }
+    return store;
+  }
 
  public:
   MyCell() : Base() {}
   explicit MyCell(const Real3& position) : Base(position) {}
 
-  // Method to set the temperature (e.g., from preCICE data)
+  // Method to set the temperature (initial value, or mirror of the coupled value)
   void SetTemperature(double temp) { temperature_ = temp; }
 
-  // Method to get the stored temperature (e.g., for use in behaviors)
-  double GetTemperature() const { return temperature_; }
+  // Method to get the temperature (e.g., for use in behaviors). Coupled cells
+  // read it from the coupled field store, other cells use their own value.
+  double GetTemperature() const {
+    if (const auto* store = CoupledStore()) {
+      return store->Get(GetCoupledFieldView().temperature, vertex_index_);
+    }
+    return temperature_;
+  }
+
+  // Component c of another coupled field (an index of
+  // PreciceAdapter::AddReadField(), e.g. oxygen) at this cell, 0 if the cell
+  // is not coupled
+  double GetCoupledValue(size_t field, int c = 0) const {
+    if (const auto* store = CoupledStore()) {
+      return store->Get(field, vertex_index_, c);
+    }
+    return 0.0;
+  }
 
   // Methods for cell coloring
   void SetCellColor(const Double3& color) { cell_color_ = color; }
-  const Double3& GetCellColor() const { return cell_color_; }
+  Double3 GetCellColor() const {
+    if (const auto* store = CoupledStore()) {
+      return {store->GetRed(vertex_index_), store->GetGreen(vertex_index_),
+              store->GetBlue(vertex_index_)};
+    }
+    return cell_color_;
+  }
+
+  // Metabolic heat release rate [W]
+  void SetHeatRelease(double heat_release) { heat_release_ = heat_release; }
+  double GetHeatRelease() const { return heat_release_; }
+
+  // preCICE vertex (index into the coupled field store) of this cell
+  void SetVertexIndex(int64_t vertex_index) { vertex_index_ = vertex_index; }
+  int64_t GetVertexIndex() const { return vertex_index_; }
+
+  // Copy the coupled values into the data members. The members are what the
+  // visualization exports, so this is only needed before an export.
+  void SyncCoupledValues() {
+    if (CoupledStore() != nullptr) {
+      temperature_ = GetTemperature();
+      cell_color_ = GetCellColor();
+    }
+  }
 
   // Add any other custom properties or behaviors specific to MyCell later.
 };
 
+// Temperature range of the blue (300 K) to red (450 K) color map
+constexpr double kColorMapMinTemperature = 300.0;
+constexpr double kColorMapMaxTemperature = 450.0;
+
 } // namespace bdm
 
 #endif // MY_CELL_H_
\ No newline at end of file
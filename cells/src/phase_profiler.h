@@ -0,0 +1,178 @@
+#ifndef PHASE_PROFILER_H_
+#define PHASE_PROFILER_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bdm {
+
+// Records how long each phase of the BioDynaMo coupling loop takes in
+// every window (read, apply, simulate, write, advance), see Report() for
+// the percentiles. WriteTrace() exports the same calls as a Chrome trace.
+// Timestamps use the system clock (microseconds since the epoch), the clock
+// of the preCICE and OpenFOAM traces, so all three line up in Perfetto.
+// When disabled, a Scope is a single branch.
+class PhaseProfiler {
+ public:
+  using Clock = std::chrono::system_clock;
+
+  struct Summary {
+    std::string phase;
+    uint64_t count = 0;
+    double total = 0;  // All durations in microseconds
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double max = 0;
+  };
+
+  // Measures one call of a phase, from construction to destruction
+  class Scope {
+   public:
+    Scope(PhaseProfiler* profiler, size_t phase)
+        : profiler_(profiler->IsEnabled() ? profiler : nullptr), phase_(phase) {
+      if (profiler_ != nullptr) {
+        start_ = Clock::now();
+      }
+    }
+    ~Scope() {
+      if (profiler_ != nullptr) {
+        profiler_->Record(phase_, start_, Clock::now());
+      }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    PhaseProfiler* profiler_;
+    size_t phase_;
+    Clock::time_point start_;
+  };
+
+  explicit PhaseProfiler(bool enabled = false) : enabled_(enabled) {}
+
+  bool IsEnabled() const { return enabled_; }
+  void SetEnabled(bool enabled) { enabled_ = enabled; }
+
+  // Add a phase and return its index
+  size_t AddPhase(const std::string& name) {
+    phases_.push_back(name);
+    return phases_.size() - 1;
+  }
+
+  const std::string& GetPhaseName(size_t phase) const { return phases_[phase]; }
+
+  void Record(size_t phase, Clock::time_point start, Clock::time_point end) {
+    events_.push_back({phase, ToMicroseconds(start),
+                       ToMicroseconds(end) - ToMicroseconds(start)});
+  }
+
+  // Record a call with explicit timestamps (microseconds since the epoch)
+  void Record(size_t phase, int64_t start, int64_t duration) {
+    events_.push_back({phase, start, duration});
+  }
+
+  size_t GetNumEvents() const { return events_.size(); }
+
+  // Statistics of every phase that was called at least once
+  std::vector<Summary> Summarize() const {
+    std::vector<std::vector<double>> durations(phases_.size());
+    for (const auto& event : events_) {
+      durations[event.phase].push_back(event.duration);
+    }
+    std::vector<Summary> summaries;
+    for (size_t p = 0; p < phases_.size(); ++p) {
+      auto& d = durations[p];
+      if (d.empty()) {
+        continue;
+      }
+      Summary s;
+      s.phase = phases_[p];
+      s.count = d.size();
+      for (double x : d) {
+        s.total += x;
+      }
+      s.mean = s.total / s.count;
+      s.p50 = Percentile(&d, 0.50);
+      s.p99 = Percentile(&d, 0.99);
+      s.max = *std::max_element(d.begin(), d.end());
+      summaries.push_back(s);
+    }
+    return summaries;
+  }
+
+  // Table of the phase statistics, in milliseconds
+  std::string Report() const {
+    std::ostringstream out;
+    out << "phase                 calls    total[ms]     mean[ms]      p50[ms]"
+           "      p99[ms]      max[ms]\n";
+    char line[160];
+    for (const auto& s : Summarize()) {
+      snprintf(line, sizeof(line), "%-20s %6llu %12.3f %12.3f %12.3f %12.3f %12.3f\n",
+               s.phase.c_str(), static_cast<unsigned long long>(s.count),
+               s.total / 1e3, s.mean / 1e3, s.p50 / 1e3, s.p99 / 1e3,
+               s.max / 1e3);
+      out << line;
+    }
+    return out.str();
+  }
+
+  // Write the calls as complete ("X") events of process `pid`, named
+  // `process_name`. The pid must differ from those of the other traces that
+  // are opened together (the OpenFOAM adapter uses its MPI ranks). Returns
+  // false if the file cannot be written.
+  bool WriteTrace(const std::string& file_name, const std::string& process_name,
+                  int pid) const {
+    std::ofstream out(file_name);
+    if (!out) {
+      return false;
+    }
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"args\":{\"name\":\"" << process_name << "\"}}";
+    for (const auto& event : events_) {
+      out << ",\n{\"name\":\"" << phases_[event.phase]
+          << "\",\"cat\":\"coupling\",\"ph\":\"X\",\"ts\":" << event.start
+          << ",\"dur\":" << event.duration << ",\"pid\":" << pid
+          << ",\"tid\":0}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(out);
+  }
+
+ private:
+  struct Event {
+    size_t phase;
+    int64_t start;     // Microseconds since the epoch
+    int64_t duration;  // Microseconds
+  };
+
+  static int64_t ToMicroseconds(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               t.time_since_epoch())
+        .count();
+  }
+
+  // Nearest-rank percentile (reorders the values)
+  static double Percentile(std::vector<double>* values, double q) {
+    size_t rank = static_cast<size_t>(std::ceil(q * values->size()));
+    rank = std::min(values->size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(values->begin(), values->begin() + rank, values->end());
+    return (*values)[rank];
+  }
+
+  bool enabled_;
+  std::vector<std::string> phases_;
+  std::vector<Event> events_;
+};
+
+}  // namespace bdm
+
+#endif  // PHASE_PROFILER_H_
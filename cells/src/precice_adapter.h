@@ -2,47 +2,138 @@
 #define PRECICE_ADAPTER_H_
 
 #include "biodynamo.h"
-#include "precice/precice.hpp" 
+#include <array>
 #include <vector>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <algorithm>
+#include <memory>
 
+#include "cell_locator.h"
+#include "coupled_field_store.h"
+#include "coupling_log.h"
+#include "coupling_participant.h"
+#include "coupling_snapshot.h"
 #include "my_cell.h" 
+#include "scatter_add.h"
 
 namespace bdm {
 
+// The adapter couples the MyCell agents in one of two modes:
+// - mesh: the agent positions at the start are registered as the CellMesh,
+//   which cannot change after initialization.
+// - just-in-time: the OpenFOAM VolumeMesh is received (direct access) and
+//   the temperature is mapped to the current agent positions in every window
+//   with mapAndReadData(). Agents may move, divide and die.
+// In both modes, the heat released by the agents is deposited into the cells
+// of the received VolumeMesh (direct access) and written as Q.
+// The adapter reads the temperature T and any further fields added with
+// AddReadField() (e.g. oxygen, or the velocity), all into the same coupled
+// field store and in one pass over the vertex IDs per read.
+// With a replay file, the temperature comes from a record of an earlier
+// OpenFOAM run (ReplayParticipant) instead of preCICE.
 class PreciceAdapter {
  public:
-  PreciceAdapter(const std::string& config_file, const std::string& participant_name)
-      : interface_(participant_name, config_file, 0, 1),
-        mesh_name_("CellMesh"),
-        temperature_data_name_("T") {
+  PreciceAdapter(const std::string& config_file, const std::string& participant_name,
+                 bool just_in_time = false, const std::string& replay_file = "")
+      : PreciceAdapter(MakeParticipant(config_file, participant_name, replay_file),
+                       just_in_time) {
     Log::Info("PreciceAdapter", "Adapter created for participant: ", participant_name);
-    Log::Info("PreciceAdapter", "Using mesh name: ", mesh_name_);
-    Log::Info("PreciceAdapter", "Using data name: ", temperature_data_name_);
   }
 
+  // Couple through any participant (e.g. a stand-in for benchmarks)
+  explicit PreciceAdapter(std::unique_ptr<CouplingParticipant> participant,
+                          bool just_in_time = false)
+      : interface_(std::move(participant)),
+        mesh_name_(just_in_time ? "VolumeMesh" : "CellMesh"),
+        received_mesh_name_("VolumeMesh"),
+        temperature_data_name_("T"),
+        heat_data_name_("Q"),
+        just_in_time_(just_in_time) {
+    Log::Info("PreciceAdapter", "Using mesh name: ", mesh_name_,
+              just_in_time_ ? " (just-in-time mapping)" : "");
+
+    // The MyCell accessors read the coupled values from our store
+    temperature_field_ = AddReadField(temperature_data_name_, 1);
+    GetCoupledFieldView() = {&store_, temperature_field_};
+    heat_field_ = store_.AddField(heat_data_name_, 1);
+  }
+
+  ~PreciceAdapter() { GetCoupledFieldView() = {}; }
+
   // Add this method to safely check before initialization
   bool WillRequireInitialData() {
-    // Cannot call interface_.requiresInitialData() before initialization
+    // Cannot call interface_->RequiresInitialData() before initialization
     // Conservatively return true to be safe
     return true;
   }
 
+  // Read a further field (`components` values per vertex) of OpenFOAM in
+  // every read, next to the temperature, and return its index in the field
+  // store. The field must be read on our mesh in the preCICE configuration.
+  // Adding a field that is already read returns its index.
+  size_t AddReadField(const std::string& name, int components) {
+    const int existing = store_.FindField(name);
+    if (existing >= 0) {
+      return existing;
+    }
+    const size_t field = store_.AddField(name, components);
+    read_fields_.push_back(field);
+    Log::Info("PreciceAdapter", "Reading ", components == 1 ? "scalar" : "vector",
+              " field ", name, " on ", mesh_name_);
+    return field;
+  }
+
+  // Store indices of the fields that are read, the temperature first
+  const std::vector<size_t>& GetReadFields() const { return read_fields_; }
+
+  // Locator of the OpenFOAM cells, for mapping the vertices to cells
+  void SetCellLocator(const CellLocator* locator) { locator_ = locator; }
+
+  // Region of the received VolumeMesh that is accessed directly (sampled and
+  // heated by the agents), as {x_min, x_max, y_min, y_max, z_min, z_max}.
+  // Must be set before Initialize().
+  void SetAccessRegion(const std::array<double, 6>& bounding_box) {
+    access_region_ = bounding_box;
+  }
+
+  // Deposit the heat released by the agents into the fluid (default). Turn
+  // it off for configurations without the received VolumeMesh and Q (e.g.
+  // ../precice-config-direct-access.xml). Must be set before Initialize().
+  void SetHeatRelease(bool enabled) { heat_release_ = enabled; }
+
   void Initialize() {
     Log::Info("PreciceAdapter", "Initializing preCICE interface...");
-    interface_.initialize();
+    // Just-in-time mapping samples the received VolumeMesh in any case
+    if (heat_release_ || just_in_time_) {
+      interface_->SetMeshAccessRegion(
+          received_mesh_name_, precice::span<const double>(access_region_.data(),
+                                                           access_region_.size()));
+    }
+    interface_->Initialize();
+    initialized_ = true;
+
+    // The received vertices are only known after initialization
+    if (heat_release_) {
+      LocateReceivedVertices();
+    } else {
+      Log::Info("PreciceAdapter", "Heat release not coupled");
+    }
     Log::Info("PreciceAdapter", "preCICE interface initialized successfully.");
   }
 
+  // Collect the agent positions. Just-in-time mapping: call this in every
+  // window, the positions are where the temperature is sampled. Otherwise:
+  // register the positions as the CellMesh, once, before Initialize().
   void UpdateMesh(Simulation& simulation) {
-    // We can't check if preCICE is initialized in this version of the API
-    // Instead, we'll use a flag that we maintain ourselves
-    static bool meshAlreadySet = false;
-    
-    if (meshAlreadySet) {
-      // Skip mesh modification after first setup
+    if (just_in_time_) {
+      UpdateSamplePoints(simulation);
+      return;
+    }
+
+    if (initialized_) {
+      // preCICE does not allow mesh modifications after initialization
       Log::Info("PreciceAdapter", "UpdateMesh: Mesh already registered with preCICE, skipping modification");
       return;
     }
@@ -50,12 +141,11 @@ class PreciceAdapter {
     // Continue with mesh setup
     Log::Info("PreciceAdapter", "UpdateMesh: Setting up mesh vertices...");
     Log::Info("PreciceAdapter", "Using RIGHT-HANDED XYZ coordinate system");
-    Log::Info("PreciceAdapter", "Domain extents: (0,0,0) to (1,1,1)");
     
     auto* rm = simulation.GetResourceManager();
     positions_.clear();
     vertex_ids_.clear();
-    cell_agent_map_.clear();
+    vertex_agents_.clear();
 
     // First, collect all MyCell agents and their positions
     std::vector<std::tuple<double, double, double, MyCell*>> sorted_cells;
@@ -72,41 +162,31 @@ class PreciceAdapter {
     
     Log::Info("PreciceAdapter", "UpdateMesh: Collected ", sorted_cells.size(), " MyCell agents");
 
-    // Store information about OpenFOAM mesh structure (from blockMeshDict)
-    const int openfoam_cells_per_dim = 50; // 50x50x50 cells from blockMeshDict
-    const double domain_size = 1.0;
-    const double openfoam_cell_size = domain_size / openfoam_cells_per_dim;
-    
-    Log::Info("PreciceAdapter", "OpenFOAM mesh: ", openfoam_cells_per_dim, "×", 
-              openfoam_cells_per_dim, "×", openfoam_cells_per_dim, 
-              " cells (cell size: ", openfoam_cell_size, ")");
-    
     // Reserve space for positions array (3 coordinates per cell)
     positions_.reserve(sorted_cells.size() * 3);
+    vertex_agents_.reserve(sorted_cells.size());
     
-    // Add each cell's position to the positions array and map to OF cell
+    // Add each cell's position to the positions array
     for (const auto& [x, y, z, cell] : sorted_cells) {
       // Store x, y, z coordinates for each cell
       positions_.push_back(x);
       positions_.push_back(y);
       positions_.push_back(z);
       
-      // Calculate which OpenFOAM cell this BioDynaMo cell maps to
-      int of_cell_x = static_cast<int>(x / openfoam_cell_size);
-      int of_cell_y = static_cast<int>(y / openfoam_cell_size);
-      int of_cell_z = static_cast<int>(z / openfoam_cell_size);
-      
-      // Clamp to valid range
-      of_cell_x = std::max(0, std::min(of_cell_x, openfoam_cells_per_dim - 1));
-      of_cell_y = std::max(0, std::min(of_cell_y, openfoam_cells_per_dim - 1));
-      of_cell_z = std::max(0, std::min(of_cell_z, openfoam_cells_per_dim - 1));
-      
-      // Calculate linear index for this OpenFOAM cell
-      int of_cell_index = of_cell_x + of_cell_y * openfoam_cells_per_dim + 
-                         of_cell_z * openfoam_cells_per_dim * openfoam_cells_per_dim;
-      
-      // Store mapping from agent to OF cell 
-      cell_agent_map_.push_back({cell->GetUid(), of_cell_index});
+      // Dense vertex index -> agent table, in preCICE vertex order
+      cell->SetVertexIndex(vertex_agents_.size());
+      vertex_agents_.push_back(cell->GetAgentPtr<MyCell>());
+    }
+
+    // Map every vertex to the OpenFOAM cell that contains it (batched)
+    UpdateVertexCells();
+    if (COUPLING_LOG_ON(CouplingLog::kDebug)) {
+      for (size_t i = 0; i < std::min<size_t>(vertex_cells_.size(), 10); ++i) {
+        COUPLING_LOG(CouplingLog::kDebug, "Vertex ", i, " at position (",
+                     positions_[3 * i], ", ", positions_[3 * i + 1], ", ",
+                     positions_[3 * i + 2], ") maps to OF cell ",
+                     vertex_cells_[i]);
+      }
     }
 
     // Calculate number of vertices from positions array (3 coords per vertex)
@@ -119,115 +199,222 @@ class PreciceAdapter {
 
     // Resize vertex IDs array to match number of vertices
     vertex_ids_.resize(num_vertices);
+
+    // Allocate the coupled fields, preCICE reads straight into them
+    store_.Resize(num_vertices);
     
     // Register the mesh vertices with preCICE
     Log::Info("PreciceAdapter", "UpdateMesh: Registering ", num_vertices, " vertices with preCICE");
     
-    interface_.setMeshVertices(
+    interface_->SetMeshVertices(
         mesh_name_,
         precice::span<const double>(positions_.data(), positions_.size()), 
         precice::span<int>(vertex_ids_.data(), vertex_ids_.size()));
     
     Log::Info("PreciceAdapter", "UpdateMesh: Successfully registered ", num_vertices, " vertices with preCICE");
-    
-    // Print the first few vertex IDs and positions for debugging
-    int debug_count = std::min(static_cast<size_t>(10), num_vertices);
-    for (int i = 0; i < debug_count; i++) {
-      Log::Info("PreciceAdapter", "Vertex ", i, " (ID: ", vertex_ids_[i], 
-                ") at position (", positions_[i*3], ", ", positions_[i*3+1], 
-                ", ", positions_[i*3+2], ") maps to OF cell ", cell_agent_map_[i].second);
+  }
+
+  // Read all fields of the current window into the coupled field store
+  // (in vertex order, straight into the array of every field). Returns false
+  // if nothing was read. relative_read_time is the time since the start of
+  // the window; preCICE interpolates the fields in time within the window.
+  bool ReadFields(double relative_read_time = 0.0) {
+    return ReadFieldsInto(&store_, relative_read_time);
+  }
+
+ private:
+  // Read every field for the same vertices: the vertex IDs (mesh mode) or
+  // the sample positions (just-in-time mapping) are shared by all fields
+  bool ReadFieldsInto(CoupledFieldStore* store, double relative_read_time) {
+    if (just_in_time_ ? vertex_agents_.empty() : vertex_ids_.empty()) {
+      COUPLING_LOG_EVERY_SECONDS(CouplingLog::kWarning, 10,
+                                 "No vertices coupled with preCICE, cannot read data");
+      return false;
     }
-    
-    // Mark that mesh has been set
-    meshAlreadySet = true;
-  }
-
-  void ReadTemperature(std::vector<double>& temperatures) {
-     size_t num_vertices = vertex_ids_.size();
-
-     if (num_vertices == 0) {
-         // Use std::cout directly for critical debugging - will be visible regardless of log level
-         std::cout << "CRITICAL DEBUG: No vertices registered with preCICE, cannot read temperature data" << std::endl;
-         temperatures.clear();
-         return;
-     }
-
-     temperatures.resize(num_vertices); // Ensure output buffer is correctly sized
-     
-     // Use direct console output for critical debugging
-     std::cout << "CRITICAL DEBUG: Attempting to read temperature data for " << num_vertices << " vertices" << std::endl;
-
-     // *** Use the 5-argument span-based readData ***
-     double relative_read_time = 0.0; // Usually 0.0 for current time step
-
-     try {
-         interface_.readData(
-             mesh_name_,                                                      // 1. Mesh Name
-             temperature_data_name_,                                          // 2. Data Name
-             precice::span<const int>(vertex_ids_.data(), vertex_ids_.size()), // 3. Vertex IDs
-             relative_read_time,                                              // 4. Relative Read Time
-             precice::span<double>(temperatures.data(), temperatures.size())); // 5. Output Data
-
-         // Enhanced debugging: Print temperature values with direct console output
-         if (!temperatures.empty()) {
-             std::cout << "CRITICAL DEBUG: Successfully read " << temperatures.size() << " temperature values" << std::endl;
-             std::cout << "CRITICAL DEBUG: First few temperature values: ";
-             
-             // Print first few temperatures (max 5) with detailed info
-             int max_to_print = std::min(static_cast<size_t>(5), temperatures.size());
-             for (int i = 0; i < max_to_print; i++) {
-                 std::cout << temperatures[i];
-                 if (i < max_to_print - 1) std::cout << ", ";
-             }
-             std::cout << std::endl;
-             
-             // Also calculate min/max/avg for easy verification
-             if (!temperatures.empty()) {
-                 double min_temp = *std::min_element(temperatures.begin(), temperatures.end());
-                 double max_temp = *std::max_element(temperatures.begin(), temperatures.end());
-                 double sum = std::accumulate(temperatures.begin(), temperatures.end(), 0.0);
-                 double avg_temp = sum / temperatures.size();
-                 
-                 std::cout << "CRITICAL DEBUG: Temperature stats - Min: " << min_temp 
-                           << ", Max: " << max_temp << ", Avg: " << avg_temp << std::endl;
-             }
-         } else {
-             std::cout << "CRITICAL DEBUG: Temperature data array is empty after readData!" << std::endl;
-         }
-     } catch (const std::exception& e) {
-         std::cout << "CRITICAL DEBUG: Exception reading temperature data: " << e.what() << std::endl;
-         temperatures.clear();
-     }
-  }
-
-  // Return the BDM agent to OpenFOAM cell index mapping
-  const std::vector<std::pair<AgentUid, int>>& GetCellAgentMap() const {
-    return cell_agent_map_;
+
+    const precice::span<const int> ids(vertex_ids_.data(), vertex_ids_.size());
+    const precice::span<const double> positions(positions_.data(),
+                                                positions_.size());
+    for (size_t field : read_fields_) {
+      const std::string& name = store->GetFieldName(field);
+      const precice::span<double> values(store->Data(field), store->Size(field));
+      try {
+        if (just_in_time_) {
+          interface_->MapAndReadData(mesh_name_, name, positions,
+                                     relative_read_time, values);
+        } else {
+          interface_->ReadData(mesh_name_, name, ids, relative_read_time,
+                               values);
+        }
+      } catch (const std::exception& e) {
+        Log::Error("PreciceAdapter", "Exception reading ", name, " data: ", e.what());
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Colors of the temperature and statistics of all read fields, in one
+  // pass over the store. Returns the statistics of the temperature.
+  FieldStats ApplyFields(CoupledFieldStore* store,
+                         std::vector<FieldStats>* stats) const {
+    store->Apply(read_fields_, temperature_field_, kColorMapMinTemperature,
+                 kColorMapMaxTemperature, stats);
+    return stats->front();
+  }
+
+ public:
+  // Deposit the heat released by the agents into the cells of the received
+  // mesh and write it as Q (one value per received vertex, in W). The sum
+  // over the received vertices equals the sum over the agents.
+  void WriteHeatRelease() {
+    if (!heat_release_) {
+      return;
+    }
+    const int64_t num_vertices = vertex_agents_.size();
+    double* heat = store_.Data(heat_field_);
+#pragma omp parallel for
+    for (int64_t i = 0; i < num_vertices; ++i) {
+      MyCell* cell = vertex_agents_[i].Get();
+      heat[i] = cell != nullptr ? cell->GetHeatRelease() : 0.0;
+    }
+
+    heat_plan_.Apply(heat, received_heat_.data());
+
+    try {
+      interface_->WriteData(
+          received_mesh_name_, heat_data_name_,
+          precice::span<const int>(received_ids_.data(), received_ids_.size()),
+          precice::span<const double>(received_heat_.data(), received_heat_.size()));
+    } catch (const std::exception& e) {
+      Log::Error("PreciceAdapter", "Exception writing heat release data: ", e.what());
+    }
+  }
+
+  // Coupled fields of the last read, in vertex order
+  const CoupledFieldStore& GetFieldStore() const { return store_; }
+
+  // Update the colors from the temperatures of the last read and compute the
+  // statistics of all read fields. Returns those of the temperature, see
+  // GetFieldStats() for the others. Both run over the store arrays, the
+  // agents are not touched.
+  FieldStats ApplyFields() { return ApplyFields(&store_, &stats_); }
+
+  // Statistics of the read fields (in the order of GetReadFields()) of the
+  // last ApplyFields()
+  const std::vector<FieldStats>& GetFieldStats() const { return stats_; }
+
+  // Copy the coupled values into the data members of the agents, which is
+  // what the visualization exports. Agents that have been removed from the
+  // simulation are skipped.
+  void SyncAgents() {
+    const int64_t num_vertices = vertex_agents_.size();
+#pragma omp parallel for
+    for (int64_t i = 0; i < num_vertices; ++i) {
+      if (MyCell* cell = vertex_agents_[i].Get()) {
+        cell->SyncCoupledValues();
+      }
+    }
+  }
+
+  // OpenFOAM cell of each vertex (-1 if outside of the mesh), in vertex
+  // order. Empty without a cell locator.
+  const std::vector<int64_t>& GetVertexCells() const { return vertex_cells_; }
+
+  // Agent of each vertex, in vertex order
+  const std::vector<AgentPointer<MyCell>>& GetVertexAgents() const {
+    return vertex_agents_;
+  }
+
+  // Received vertex that the heat of each vertex is deposited into, in
+  // vertex order
+  const std::vector<int64_t>& GetHeatTargets() const { return heat_targets_; }
+
+  // Hash of the coordinates of the received mesh (after Initialize())
+  uint64_t GetReceivedHash() const { return received_hash_; }
+
+  // Agents and their mapping, for a snapshot. Mesh mode: the agents of the
+  // vertex table, in vertex order, with their OpenFOAM cells and heat
+  // targets (left out if agents have been removed). Just-in-time mapping:
+  // all agents, including those created since the last UpdateMesh(),
+  // without mapping (it is rebuilt in every window).
+  void CaptureSnapshot(Simulation& simulation, CouplingSnapshot* snapshot) {
+    snapshot->positions.clear();
+    snapshot->diameters.clear();
+    snapshot->temperatures.clear();
+    snapshot->heat_releases.clear();
+    snapshot->vertex_cells.clear();
+    snapshot->heat_targets.clear();
+    snapshot->received_hash = 0;
+    auto add = [&](const MyCell* cell) {
+      const auto& pos = cell->GetPosition();
+      snapshot->positions.insert(snapshot->positions.end(),
+                                 {pos[0], pos[1], pos[2]});
+      snapshot->diameters.push_back(cell->GetDiameter());
+      snapshot->temperatures.push_back(cell->GetTemperature());
+      snapshot->heat_releases.push_back(cell->GetHeatRelease());
+    };
+
+    if (just_in_time_) {
+      simulation.GetResourceManager()->ForEachAgent([&](Agent* agent) {
+        if (auto* my_cell = dynamic_cast<MyCell*>(agent)) {
+          add(my_cell);
+        }
+      });
+      return;
+    }
+
+    for (auto& agent : vertex_agents_) {
+      if (MyCell* cell = agent.Get()) {
+        add(cell);
+      }
+    }
+    if (snapshot->GetNumAgents() == vertex_agents_.size()) {
+      snapshot->vertex_cells = vertex_cells_;
+      snapshot->heat_targets = heat_targets_;
+      snapshot->received_hash = received_hash_;
+    }
+  }
+
+  // Mapping of the vertices of a snapshot (mesh mode), used by UpdateMesh()
+  // and Initialize() instead of searching the cells and the received
+  // vertices again. The snapshot agents must have been restored in vertex
+  // order. The heat targets are only used if the received mesh has the
+  // same hash.
+  void RestoreMapping(std::vector<int64_t> vertex_cells,
+                      std::vector<int64_t> heat_targets,
+                      uint64_t received_hash) {
+    if (just_in_time_) {
+      return;
+    }
+    restored_vertex_cells_ = std::move(vertex_cells);
+    restored_heat_targets_ = std::move(heat_targets);
+    restored_received_hash_ = received_hash;
   }
 
   // This method should only be called AFTER initialize() has been called
   bool RequiresInitialData() {
-    return interface_.requiresInitialData();
+    return interface_->RequiresInitialData();
   }
   
   void Advance(double dt) {
-    interface_.advance(dt);
+    interface_->Advance(dt);
   }
 
   bool IsCouplingOngoing() {
-    bool ongoing = interface_.isCouplingOngoing();
+    bool ongoing = interface_->IsCouplingOngoing();
     return ongoing;
   }
 
   double GetMaxTimeStep() {
-      double dt = interface_.getMaxTimeStepSize();
+      double dt = interface_->GetMaxTimeStepSize();
       return dt;
   }
 
   void Finalize() {
     Log::Info("PreciceAdapter", "Finalizing preCICE interface...");
     try {
-        interface_.finalize();
+        interface_->Finalize();
         Log::Info("PreciceAdapter", "preCICE interface finalized.");
     } catch (const std::exception& e) {
         Log::Error("PreciceAdapter", "Exception during preCICE finalize: ", e.what());
@@ -235,12 +422,142 @@ class PreciceAdapter {
   }
 
  private:
-  precice::Participant interface_;
+  static std::unique_ptr<CouplingParticipant> MakeParticipant(
+      const std::string& config_file, const std::string& participant_name,
+      const std::string& replay_file) {
+    if (replay_file.empty()) {
+      return std::unique_ptr<CouplingParticipant>(
+          new PreciceParticipant(participant_name, config_file));
+    }
+    return std::unique_ptr<CouplingParticipant>(new ReplayParticipant(replay_file));
+  }
+
+  // Fetch the vertices of the received mesh (direct access) and index them,
+  // so that every agent can be assigned to the received vertex (OpenFOAM
+  // cell centre) nearest to it
+  void LocateReceivedVertices() {
+    const int num_received = interface_->GetMeshVertexSize(received_mesh_name_);
+    received_ids_.resize(num_received);
+    std::vector<double> coords(3 * num_received);
+    interface_->GetMeshVertexIDsAndCoordinates(
+        received_mesh_name_,
+        precice::span<int>(received_ids_.data(), received_ids_.size()),
+        precice::span<double>(coords.data(), coords.size()));
+    received_hash_ = HashValues(coords.data(), coords.size());
+    received_heat_.assign(num_received, 0.0);
+    Log::Info("PreciceAdapter", "Received ", num_received, " vertices of ",
+              received_mesh_name_);
+
+    // The heat targets of a snapshot of the same received mesh
+    const size_t num_vertices = positions_.size() / 3;
+    if (restored_heat_targets_.size() == num_vertices &&
+        restored_received_hash_ == received_hash_ && num_vertices > 0) {
+      heat_targets_.swap(restored_heat_targets_);
+      heat_plan_.Build(heat_targets_.data(), num_vertices, num_received);
+      Log::Info("PreciceAdapter", "Restored the heat targets of ",
+                num_vertices, " vertices");
+      restored_heat_targets_.clear();
+      return;
+    }
+    restored_heat_targets_.clear();
+
+    received_locator_.SetCellCentres(coords.data(), num_received);
+    UpdateHeatTargets();
+  }
+
+  // Group the vertices by the received vertex their heat is deposited into
+  void UpdateHeatTargets() {
+    if (!initialized_ || !heat_release_) {
+      return;
+    }
+    const size_t num_vertices = positions_.size() / 3;
+    heat_targets_.resize(num_vertices);
+    received_locator_.FindNearestCells(positions_.data(), num_vertices,
+                                       heat_targets_.data());
+    heat_plan_.Build(heat_targets_.data(), num_vertices,
+                     received_locator_.GetNumCells());
+  }
+
+  // Map the vertices to the OpenFOAM cells that contain them
+  void UpdateVertexCells() {
+    if (locator_ == nullptr) {
+      vertex_cells_.clear();
+      return;
+    }
+    const size_t num_vertices = positions_.size() / 3;
+    if (restored_vertex_cells_.size() == num_vertices && num_vertices > 0) {
+      vertex_cells_.swap(restored_vertex_cells_);
+      restored_vertex_cells_.clear();
+      return;
+    }
+    restored_vertex_cells_.clear();
+    vertex_cells_.resize(num_vertices);
+    locator_->FindCells(positions_.data(), vertex_cells_.size(),
+                        vertex_cells_.data());
+  }
+
+  // Rebuild the vertex table from the current agents (just-in-time mapping).
+  // Agents get a new vertex index in every window, so that new agents are
+  // coupled and removed agents drop out. Positions outside the access region
+  // are clamped to it, preCICE cannot sample outside of it.
+  void UpdateSamplePoints(Simulation& simulation) {
+    auto* rm = simulation.GetResourceManager();
+    vertex_agents_.clear();
+    vertex_agents_.reserve(rm->GetNumAgents());
+    rm->ForEachAgent([&](Agent* agent) {
+      if (auto* my_cell = dynamic_cast<MyCell*>(agent)) {
+        vertex_agents_.push_back(my_cell->GetAgentPtr<MyCell>());
+      }
+    });
+
+    const int64_t num_vertices = vertex_agents_.size();
+    positions_.resize(num_vertices * 3);
+    store_.Resize(num_vertices);
+
+#pragma omp parallel for
+    for (int64_t i = 0; i < num_vertices; ++i) {
+      MyCell* cell = vertex_agents_[i].Get();
+      cell->SetVertexIndex(i);
+      const auto& pos = cell->GetPosition();
+      for (int d = 0; d < 3; ++d) {
+        positions_[3 * i + d] =
+            std::min(access_region_[2 * d + 1],
+                     std::max(access_region_[2 * d], static_cast<double>(pos[d])));
+      }
+    }
+    UpdateVertexCells();
+    UpdateHeatTargets();
+  }
+
+  std::unique_ptr<CouplingParticipant> interface_;
   std::string mesh_name_;
+  std::string received_mesh_name_;
   std::string temperature_data_name_;
+  std::string heat_data_name_;
   std::vector<double> positions_;
   std::vector<int> vertex_ids_;
-  std::vector<std::pair<AgentUid, int>> cell_agent_map_; // Maps BDM agent UIDs to OpenFOAM cell indices
+  std::vector<AgentPointer<MyCell>> vertex_agents_;  // Agent of each vertex
+  std::vector<int64_t> vertex_cells_;  // OpenFOAM cell of each vertex
+  const CellLocator* locator_ = nullptr;
+  CoupledFieldStore store_;  // Coupled fields, one entry per vertex
+  size_t temperature_field_ = 0;
+  size_t heat_field_ = 0;
+  std::vector<size_t> read_fields_;     // Fields read from OpenFOAM
+  std::vector<FieldStats> stats_;  // Of the read fields
+  std::vector<int> received_ids_;      // Vertex IDs of the received mesh
+  CellLocator received_locator_;       // Index of the received vertices
+  std::vector<int64_t> heat_targets_;  // Received vertex of each vertex
+  ScatterAddPlan heat_plan_;           // Vertices grouped by heat target
+  std::vector<double> received_heat_;  // Heat per received vertex [W]
+  uint64_t received_hash_ = 0;         // Hash of the received coordinates
+  // Mapping of a snapshot, until UpdateMesh() and Initialize() use it
+  std::vector<int64_t> restored_vertex_cells_;
+  std::vector<int64_t> restored_heat_targets_;
+  uint64_t restored_received_hash_ = 0;
+  bool just_in_time_ = false;
+  bool heat_release_ = true;  // Couple the heat release (VolumeMesh, Q)
+  bool initialized_ = false;
+  std::array<double, 6> access_region_ = {0.0, 1.0, 0.0, 1.0, 0.0, 1.0};
 };
 
 } // namespace bdm
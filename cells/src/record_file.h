@@ -0,0 +1,161 @@
+#ifndef RECORD_FILE_H_
+#define RECORD_FILE_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace bdm {
+
+// Header of a coupling record, as written by the FieldRecorder of the
+// OpenFOAM adapter (FP module, option recordFile). Native byte order.
+struct RecordHeader {
+  char magic[8];  // "CPLREC01"
+  uint64_t num_vertices;
+  uint64_t num_components;
+  double window_size;  // Time between two records
+};
+static_assert(sizeof(RecordHeader) == 32, "Unexpected RecordHeader padding");
+
+// Read-only view of a coupling record file, memory-mapped. The file is the
+// header, the coordinates of the recorded vertices (3 doubles each), then one
+// record per OpenFOAM write: the time, followed by num_vertices *
+// num_components doubles. The values are read straight from the mapping,
+// nothing is copied when the file is opened.
+class RecordFile {
+ public:
+  RecordFile() = default;
+  RecordFile(const RecordFile&) = delete;
+  RecordFile& operator=(const RecordFile&) = delete;
+  ~RecordFile() { Close(); }
+
+  // Map a record file. Returns false (and sets `error`) if the file cannot
+  // be read or is not a record file.
+  bool Open(const std::string& file_name, std::string* error) {
+    Close();
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+      *error = "cannot open " + file_name;
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(RecordHeader)) {
+      close(fd);
+      *error = file_name + " is too short for a record header";
+      return false;
+    }
+    size_ = st.st_size;
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      size_ = 0;
+      *error = "cannot map " + file_name;
+      return false;
+    }
+    data_ = static_cast<const char*>(data);
+
+    const auto* header = reinterpret_cast<const RecordHeader*>(data_);
+    if (std::memcmp(header->magic, "CPLREC01", sizeof(header->magic)) != 0) {
+      Close();
+      *error = file_name + " is not a coupling record (bad magic)";
+      return false;
+    }
+    num_vertices_ = header->num_vertices;
+    num_components_ = header->num_components;
+    window_size_ = header->window_size;
+
+    // A record that is still being written (incomplete) is ignored
+    const size_t coords_bytes = 3 * num_vertices_ * sizeof(double);
+    if (size_ < sizeof(RecordHeader) + coords_bytes) {
+      Close();
+      *error = file_name + " is too short for its vertex coordinates";
+      return false;
+    }
+    record_stride_ = 1 + num_vertices_ * num_components_;
+    num_records_ = (size_ - sizeof(RecordHeader) - coords_bytes) /
+                   (record_stride_ * sizeof(double));
+    coords_ = reinterpret_cast<const double*>(data_ + sizeof(RecordHeader));
+    records_ = coords_ + 3 * num_vertices_;
+    return true;
+  }
+
+  void Close() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    num_vertices_ = num_components_ = num_records_ = 0;
+  }
+
+  size_t GetNumVertices() const { return num_vertices_; }
+  size_t GetNumComponents() const { return num_components_; }
+  size_t GetNumRecords() const { return num_records_; }
+  double GetWindowSize() const { return window_size_; }
+
+  // Coordinates of the recorded vertices (3 per vertex)
+  const double* GetCoordinates() const { return coords_; }
+
+  // Time and values (num_vertices * num_components) of a record
+  double GetTime(size_t record) const {
+    return records_[record * record_stride_];
+  }
+  const double* GetValues(size_t record) const {
+    return records_ + record * record_stride_ + 1;
+  }
+
+  // Values of the given vertices at `time`, interpolated linearly between
+  // the two records around it (first component only). Before the first and
+  // after the last record, the first / last record is used.
+  void Sample(double time, const int64_t* vertices, size_t n,
+              double* out) const {
+    if (num_records_ == 0) {
+      std::fill(out, out + n, 0.0);
+      return;
+    }
+    // Last record with a time <= `time`
+    size_t lo = 0;
+    size_t hi = num_records_;
+    while (hi - lo > 1) {
+      const size_t mid = (lo + hi) / 2;
+      (GetTime(mid) <= time ? lo : hi) = mid;
+    }
+    const size_t next = std::min(lo + 1, num_records_ - 1);
+    double alpha = 0.0;
+    if (next != lo && time > GetTime(lo)) {
+      alpha = std::min(1.0, (time - GetTime(lo)) / (GetTime(next) - GetTime(lo)));
+    }
+
+    const double* v0 = GetValues(lo);
+    const double* v1 = GetValues(next);
+    const size_t nc = num_components_;
+    const int64_t count = n;
+#pragma omp parallel for
+    for (int64_t i = 0; i < count; ++i) {
+      const size_t k = vertices[i] * nc;
+      out[i] = (1.0 - alpha) * v0[k] + alpha * v1[k];
+    }
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  size_t num_vertices_ = 0;
+  size_t num_components_ = 0;
+  size_t num_records_ = 0;
+  size_t record_stride_ = 1;  // Doubles per record
+  double window_size_ = 0.0;
+  const double* coords_ = nullptr;
+  const double* records_ = nullptr;
+};
+
+}  // namespace bdm
+
+#endif  // RECORD_FILE_H_
@@ -0,0 +1,152 @@
+#ifndef SCATTER_ADD_H_
+#define SCATTER_ADD_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace bdm {
+
+// Parallel scatter-add of per-source values (e.g. agents) into target bins
+// (e.g. OpenFOAM cells): sums[t] = sum of values[s] over all s with
+// targets[s] == t.
+// Build() groups the sources by target with a two-level counting sort over
+// P chunks (one per thread). Every thread counts its own range of sources per
+// range of targets (a P x P table) and, after a prefix sum, scatters them
+// into one bucket per target range. Every thread then counting-sorts its own
+// bucket by target. Each pass touches N / P sources per thread, and the
+// buffers are kept for the next Build(), which runs in every window with
+// just-in-time mapping. Apply() then turns the scatter into a gather: every
+// target is summed by exactly one thread. The sources of a target are
+// placed and summed in increasing order, so the result does not depend on
+// the number of threads. The plan only has to be rebuilt when the targets
+// change.
+class ScatterAddPlan {
+ public:
+  // Group n sources by target. Sources with a negative (or too large) target
+  // are skipped.
+  void Build(const int64_t* targets, size_t n, size_t num_targets) {
+    const int64_t num_sources = n;
+    const int64_t nt = num_targets;
+#ifdef _OPENMP
+    const int64_t num_chunks = omp_get_max_threads();
+#else
+    const int64_t num_chunks = 1;
+#endif
+    // Source range c and target range r of every chunk. Target t is in range
+    // t * P / nt, which starts at ceil(r * nt / P).
+    auto source_begin = [&](int64_t c) { return num_sources * c / num_chunks; };
+    auto target_begin = [&](int64_t r) {
+      return (r * nt + num_chunks - 1) / num_chunks;
+    };
+    auto target_range = [&](int64_t t) { return t * num_chunks / nt; };
+
+    // Sources of every (source range, target range)
+    counts_.assign(num_chunks * num_chunks, 0);
+    int64_t num_skipped = 0;
+#pragma omp parallel for schedule(static, 1) reduction(+ : num_skipped)
+    for (int64_t c = 0; c < num_chunks; ++c) {
+      int64_t* count = &counts_[c * num_chunks];
+      for (int64_t s = source_begin(c); s < source_begin(c + 1); ++s) {
+        if (targets[s] >= 0 && targets[s] < nt) {
+          count[target_range(targets[s])]++;
+        } else {
+          num_skipped++;
+        }
+      }
+    }
+    num_skipped_ = num_skipped;
+
+    // Bucket of every target range, filled by the source ranges in order
+    bucket_start_.resize(num_chunks + 1);
+    int64_t next = 0;
+    for (int64_t r = 0; r < num_chunks; ++r) {
+      bucket_start_[r] = next;
+      for (int64_t c = 0; c < num_chunks; ++c) {
+        const int64_t count = counts_[c * num_chunks + r];
+        counts_[c * num_chunks + r] = next;
+        next += count;
+      }
+    }
+    bucket_start_[num_chunks] = next;
+
+    // Every source range fills its own slots of the buckets
+    bucket_sources_.resize(next);
+    bucket_targets_.resize(next);
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t c = 0; c < num_chunks; ++c) {
+      int64_t* slot = &counts_[c * num_chunks];
+      for (int64_t s = source_begin(c); s < source_begin(c + 1); ++s) {
+        const int64_t t = targets[s];
+        if (t >= 0 && t < nt) {
+          const int64_t k = slot[target_range(t)]++;
+          bucket_sources_[k] = s;
+          bucket_targets_[k] = t;
+        }
+      }
+    }
+
+    // Every target range counting-sorts its bucket by target. The targets
+    // of range r take the slots of its bucket.
+    start_.resize(nt + 1);
+    next_.resize(nt);
+    sources_.resize(next);
+#pragma omp parallel for schedule(static, 1)
+    for (int64_t r = 0; r < num_chunks; ++r) {
+      const int64_t begin = target_begin(r);
+      const int64_t end = target_begin(r + 1);
+      std::fill(next_.begin() + begin, next_.begin() + end, 0);
+      for (int64_t k = bucket_start_[r]; k < bucket_start_[r + 1]; ++k) {
+        next_[bucket_targets_[k]]++;
+      }
+      int64_t first = bucket_start_[r];
+      for (int64_t t = begin; t < end; ++t) {
+        start_[t] = first;
+        first += next_[t];
+        next_[t] = start_[t];
+      }
+      for (int64_t k = bucket_start_[r]; k < bucket_start_[r + 1]; ++k) {
+        sources_[next_[bucket_targets_[k]]++] = bucket_sources_[k];
+      }
+    }
+    start_[nt] = next;
+  }
+
+  // sums[t] = sum of the values of the sources of target t
+  void Apply(const double* values, double* sums) const {
+    const int64_t nt = GetNumTargets();
+#pragma omp parallel for schedule(static)
+    for (int64_t t = 0; t < nt; ++t) {
+      double sum = 0.0;
+      for (int64_t k = start_[t]; k < start_[t + 1]; ++k) {
+        sum += values[sources_[k]];
+      }
+      sums[t] = sum;
+    }
+  }
+
+  size_t GetNumTargets() const { return start_.empty() ? 0 : start_.size() - 1; }
+
+  // Number of sources that were skipped (negative target)
+  size_t GetNumSkipped() const { return num_skipped_; }
+
+ private:
+  std::vector<int64_t> start_;    // First slot of every target
+  std::vector<int64_t> sources_;  // Sources, grouped by target
+  // Build() only: (source range, target range) counts, then slots
+  std::vector<int64_t> counts_;
+  std::vector<int64_t> bucket_start_;    // First slot of every bucket
+  std::vector<int64_t> bucket_sources_;  // Sources, by target range
+  std::vector<int64_t> bucket_targets_;  // Their targets
+  std::vector<int64_t> next_;            // Next free slot per target
+  size_t num_skipped_ = 0;
+};
+
+}  // namespace bdm
+
+#endif  // SCATTER_ADD_H_
@@ -0,0 +1,247 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "agent_seeding.h"
+
+namespace bdm {
+
+// Write an ascii polyMesh of the unit cube with n^3 hexahedra (cell
+// (i, j, k) is i * n * n + j * n + k). Internal faces come first.
+void WriteBoxMesh(const std::string& dir, int n) {
+  auto point = [&](int i, int j, int k) {
+    return (i * (n + 1) + j) * (n + 1) + k;
+  };
+  auto cell = [&](int i, int j, int k) { return (i * n + j) * n + k; };
+
+  std::string points;
+  for (int i = 0; i <= n; ++i) {
+    for (int j = 0; j <= n; ++j) {
+      for (int k = 0; k <= n; ++k) {
+        points += "(" + std::to_string(double(i) / n) + " " +
+                  std::to_string(double(j) / n) + " " +
+                  std::to_string(double(k) / n) + ")\n";
+      }
+    }
+  }
+
+  // Faces normal to direction d at plane l, with the cells on both sides
+  struct Face {
+    std::string points;
+    int owner, neighbour;
+  };
+  std::vector<Face> internal, boundary;
+  for (int d = 0; d < 3; ++d) {
+    for (int l = 0; l <= n; ++l) {
+      for (int a = 0; a < n; ++a) {
+        for (int b = 0; b < n; ++b) {
+          int corner[4][3];
+          const int offsets[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+          for (int c = 0; c < 4; ++c) {
+            corner[c][d] = l;
+            corner[c][(d + 1) % 3] = a + offsets[c][0];
+            corner[c][(d + 2) % 3] = b + offsets[c][1];
+          }
+          std::string face = "4(";
+          for (int c = 0; c < 4; ++c) {
+            face += std::to_string(point(corner[c][0], corner[c][1], corner[c][2])) +
+                    (c < 3 ? " " : ")\n");
+          }
+          int lower[3], upper[3];
+          lower[d] = l - 1;
+          upper[d] = l;
+          lower[(d + 1) % 3] = upper[(d + 1) % 3] = a;
+          lower[(d + 2) % 3] = upper[(d + 2) % 3] = b;
+          if (l == 0) {
+            boundary.push_back({face, cell(upper[0], upper[1], upper[2]), -1});
+          } else if (l == n) {
+            boundary.push_back({face, cell(lower[0], lower[1], lower[2]), -1});
+          } else {
+            internal.push_back({face, cell(lower[0], lower[1], lower[2]),
+                                cell(upper[0], upper[1], upper[2])});
+          }
+        }
+      }
+    }
+  }
+
+  std::string faces, owner, neighbour;
+  for (const auto& face : internal) {
+    faces += face.points;
+    owner += std::to_string(face.owner) + "\n";
+    neighbour += std::to_string(face.neighbour) + "\n";
+  }
+  for (const auto& face : boundary) {
+    faces += face.points;
+    owner += std::to_string(face.owner) + "\n";
+  }
+
+  auto write = [&](const std::string& name, size_t count,
+                   const std::string& entries) {
+    std::ofstream out(dir + "/" + name);
+    out << "FoamFile\n{\n    format ascii;\n    object " << name << ";\n}\n"
+        << count << "\n(\n" << entries << ")\n";
+  };
+  const size_t num_points = (n + 1) * (n + 1) * (n + 1);
+  write("points", num_points, points);
+  write("faces", internal.size() + boundary.size(), faces);
+  write("owner", internal.size() + boundary.size(), owner);
+  write("neighbour", internal.size(), neighbour);
+}
+
+class AgentSeedingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_NE(mkdtemp(dir_), nullptr);
+    WriteBoxMesh(dir_, 4);
+    std::string error;
+    ASSERT_TRUE(mesh_.LoadPolyMesh(dir_, &error)) << error;
+    ASSERT_EQ(64u, mesh_.GetNumCells());
+  }
+
+  void TearDown() override {
+    for (const char* name : {"points", "faces", "owner", "neighbour", "box1"}) {
+      std::remove((std::string(dir_) + "/" + name).c_str());
+    }
+    std::remove(dir_);
+  }
+
+  char dir_[32] = "/tmp/agent-seeding-testXXXXXX";
+  CellLocator mesh_;
+};
+
+TEST_F(AgentSeedingTest, Lattice) {
+  SeedingRule rule;
+  std::vector<double> positions;
+  std::string error;
+
+  // One point per cell: every cell centre
+  rule.lattice = 4;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &positions, &error)) << error;
+  ASSERT_EQ(3u * 64, positions.size());
+  EXPECT_DOUBLE_EQ(0.125, positions[0]);
+  EXPECT_DOUBLE_EQ(0.875, positions.back());
+
+  // Several points per cell: one agent per cell
+  rule.lattice = 10;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &positions, &error)) << error;
+  EXPECT_EQ(3u * 64, positions.size());
+
+  // Coarser than the mesh
+  rule.lattice = 2;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &positions, &error)) << error;
+  EXPECT_EQ(3u * 8, positions.size());
+}
+
+TEST_F(AgentSeedingTest, LatticeInCellSet) {
+  // The cells of the first x layer, read as topoSet writes them
+  {
+    std::ofstream out(std::string(dir_) + "/box1");
+    out << "FoamFile\n{\n    format ascii;\n    class cellSet;\n}\n\n16\n(\n";
+    for (int c = 0; c < 16; ++c) {
+      out << c << "\n";
+    }
+    out << ")\n";
+  }
+  std::vector<int64_t> region;
+  std::string error;
+  ASSERT_TRUE(CellLocator::ReadLabels(std::string(dir_) + "/box1", &region, &error))
+      << error;
+  ASSERT_EQ(16u, region.size());
+
+  SeedingRule rule;
+  rule.lattice = 8;
+  std::vector<double> positions;
+  ASSERT_TRUE(SeedPositions(mesh_, region, rule, &positions, &error)) << error;
+  ASSERT_EQ(3u * 16, positions.size());
+  for (size_t a = 0; a < positions.size() / 3; ++a) {
+    EXPECT_DOUBLE_EQ(0.125, positions[3 * a]);
+  }
+}
+
+TEST_F(AgentSeedingTest, EveryNthCell) {
+  SeedingRule rule;
+  rule.mode = "cells";
+  rule.stride = 5;
+  std::vector<double> positions;
+  std::string error;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &positions, &error)) << error;
+  ASSERT_EQ(3u * 13, positions.size());
+  // Cell 5 is (0, 1, 1)
+  EXPECT_DOUBLE_EQ(0.125, positions[3]);
+  EXPECT_DOUBLE_EQ(0.375, positions[4]);
+  EXPECT_DOUBLE_EQ(0.375, positions[5]);
+}
+
+TEST_F(AgentSeedingTest, Density) {
+  SeedingRule rule;
+  rule.mode = "density";
+  rule.density = 6400;  // 100 per cell
+  std::vector<double> positions;
+  std::string error;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &positions, &error)) << error;
+  ASSERT_EQ(3u * 6400, positions.size());
+
+  // Uniform over the cells: about half of the agents in each half
+  size_t lower = 0;
+  for (size_t a = 0; a < positions.size() / 3; ++a) {
+    for (int d = 0; d < 3; ++d) {
+      ASSERT_GE(positions[3 * a + d], 0.0);
+      ASSERT_LE(positions[3 * a + d], 1.0);
+    }
+    lower += positions[3 * a] < 0.5;
+  }
+  EXPECT_NEAR(3200.0, lower, 200.0);
+
+  // Reproducible, a different seed gives other positions
+  std::vector<double> again;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &again, &error));
+  EXPECT_EQ(positions, again);
+  rule.seed = 1;
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &again, &error));
+  EXPECT_NE(positions, again);
+
+  // Fractional counts per cell
+  rule.density = 32;  // 0.5 per cell
+  ASSERT_TRUE(SeedPositions(mesh_, {}, rule, &positions, &error)) << error;
+  EXPECT_GT(positions.size(), 0u);
+  EXPECT_LT(positions.size(), 3u * 64);
+}
+
+TEST_F(AgentSeedingTest, Errors) {
+  SeedingRule rule;
+  std::vector<double> positions;
+  std::string error;
+  rule.mode = "random";
+  EXPECT_FALSE(SeedPositions(mesh_, {}, rule, &positions, &error));
+  rule.mode = "density";
+  EXPECT_FALSE(SeedPositions(mesh_, {}, rule, &positions, &error));
+  rule.mode = "cells";
+  EXPECT_FALSE(SeedPositions(mesh_, {64}, rule, &positions, &error));
+
+  // The density needs the cell bounds
+  CellLocator centres;
+  const double centre[3] = {0.5, 0.5, 0.5};
+  centres.SetCellCentres(centre, 1);
+  rule.mode = "density";
+  rule.density = 1;
+  EXPECT_FALSE(SeedPositions(centres, {}, rule, &positions, &error));
+}
+
+}  // namespace bdm
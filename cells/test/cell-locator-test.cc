@@ -0,0 +1,150 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "cell_locator.h"
+
+namespace bdm {
+
+// Nearest centre by brute force
+int64_t BruteForceNearest(const std::vector<double>& centres, const double* p) {
+  int64_t best = -1;
+  double best_dist2 = 1e300;
+  for (size_t c = 0; c < centres.size() / 3; ++c) {
+    double dist2 = 0;
+    for (int d = 0; d < 3; ++d) {
+      dist2 += (centres[3 * c + d] - p[d]) * (centres[3 * c + d] - p[d]);
+    }
+    if (dist2 < best_dist2) {
+      best_dist2 = dist2;
+      best = c;
+    }
+  }
+  return best;
+}
+
+TEST(CellLocatorTest, NearestCellMatchesBruteForce) {
+  std::mt19937 rng(42);
+  // Graded in x, flat in z
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<double> centres;
+  for (int c = 0; c < 2000; ++c) {
+    const double x = uniform(rng);
+    centres.insert(centres.end(), {x * x * x, 0.5 * uniform(rng), 0.0});
+  }
+
+  CellLocator locator;
+  locator.SetCellCentres(centres.data(), 2000);
+  EXPECT_EQ(locator.GetNumCells(), 2000u);
+
+  std::vector<double> points;
+  for (int i = 0; i < 500; ++i) {
+    points.insert(points.end(), {1.4 * uniform(rng) - 0.2, uniform(rng),
+                                 0.1 * uniform(rng) - 0.05});
+  }
+  std::vector<int64_t> cells(500);
+  locator.FindNearestCells(points.data(), 500, cells.data());
+  for (int i = 0; i < 500; ++i) {
+    const int64_t expected = BruteForceNearest(centres, &points[3 * i]);
+    EXPECT_EQ(cells[i], expected) << "point " << i;
+  }
+}
+
+// Write a 2x1x1 hex mesh of [x[0],x[2]]x[0,1]x[0,1] as an ascii polyMesh
+void WriteTwoCellMesh(const std::string& dir,
+                      const std::vector<double>& x = {0.0, 1.0, 2.0}) {
+  const char* header =
+      "FoamFile\n{\n    format      ascii;\n    class       %s;\n}\n"
+      "// * * * //\n\n";
+  auto write = [&](const std::string& name, const std::string& cls,
+                   const std::string& body) {
+    std::ofstream out(dir + "/" + name);
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), header, cls.c_str());
+    out << buffer << body;
+  };
+  std::string points = "12\n(\n";
+  for (int k = 0; k < 2; ++k) {
+    for (int j = 0; j < 2; ++j) {
+      for (int i = 0; i < 3; ++i) {
+        points += "(" + std::to_string(x[i]) + " " + std::to_string(j) + " " +
+                  std::to_string(k) + ")\n";
+      }
+    }
+  }
+  write("points", "vectorField", points + ")\n");
+  // Point (i, j, k) has index i + 3 * j + 6 * k. Internal face first.
+  write("faces", "faceList",
+        "11\n(\n4(1 7 10 4)\n"
+        "4(0 6 9 3)\n4(0 1 4 3)\n4(6 9 10 7)\n4(0 3 9 6)\n4(1 4 10 7)\n"
+        "4(2 8 11 5)\n4(1 2 5 4)\n4(7 10 11 8)\n4(1 7 8 2)\n4(4 5 11 10)\n)\n");
+  write("owner", "labelList", "11\n(\n0\n0\n0\n0\n0\n0\n1\n1\n1\n1\n1\n)\n");
+  write("neighbour", "labelList", "1\n(\n1\n)\n");
+}
+
+TEST(CellLocatorTest, LoadPolyMesh) {
+  char dir[] = "/tmp/cell-locator-testXXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  WriteTwoCellMesh(dir);
+
+  CellLocator locator;
+  std::string error;
+  ASSERT_TRUE(locator.LoadPolyMesh(dir, &error)) << error;
+  ASSERT_EQ(locator.GetNumCells(), 2u);
+  EXPECT_DOUBLE_EQ(locator.GetCentre(0)[0], 0.5);
+  EXPECT_DOUBLE_EQ(locator.GetCentre(1)[0], 1.5);
+  EXPECT_DOUBLE_EQ(locator.GetCentre(1)[2], 0.5);
+  EXPECT_DOUBLE_EQ(locator.GetBounds()[1], 2.0);
+
+  const double inside[3] = {1.9, 0.1, 0.9};
+  const double outside[3] = {2.1, 0.5, 0.5};
+  EXPECT_EQ(locator.FindCell(inside), 1);
+  EXPECT_EQ(locator.FindCell(outside), -1);
+  EXPECT_EQ(locator.FindNearestCell(outside), 1);
+
+  EXPECT_FALSE(locator.LoadPolyMesh(std::string(dir) + "/missing", &error));
+  for (const char* name : {"points", "faces", "owner", "neighbour"}) {
+    std::remove((std::string(dir) + "/" + name).c_str());
+  }
+  std::remove(dir);
+}
+
+TEST(CellLocatorTest, GradedPolyMesh) {
+  char dir[] = "/tmp/cell-locator-testXXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  // Cells [0,1] and [1,1.1]: the nearest centre of x = 0.9 is that of cell 1
+  WriteTwoCellMesh(dir, {0.0, 1.0, 1.1});
+
+  CellLocator locator;
+  std::string error;
+  ASSERT_TRUE(locator.LoadPolyMesh(dir, &error)) << error;
+  const double in_large[3] = {0.9, 0.5, 0.5};
+  const double in_small[3] = {1.05, 0.5, 0.5};
+  const double outside[3] = {1.2, 0.5, 0.5};
+  EXPECT_EQ(locator.FindNearestCell(in_large), 1);
+  EXPECT_EQ(locator.FindCell(in_large), 0);
+  EXPECT_EQ(locator.FindCell(in_small), 1);
+  EXPECT_EQ(locator.FindCell(outside), -1);
+
+  for (const char* name : {"points", "faces", "owner", "neighbour"}) {
+    std::remove((std::string(dir) + "/" + name).c_str());
+  }
+  std::remove(dir);
+}
+
+}  // namespace bdm
@@ -0,0 +1,128 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "coupled_field_store.h"
+
+namespace bdm {
+
+TEST(CoupledFieldStoreTest, FieldsFollowResize) {
+  CoupledFieldStore store;
+  size_t t = store.AddField("T", 1);
+  store.Resize(4);
+  size_t u = store.AddField("U", 3);
+
+  EXPECT_EQ(store.AddField("T", 1), t);
+  EXPECT_EQ(store.FindField("U"), static_cast<int>(u));
+  EXPECT_EQ(store.FindField("p"), -1);
+  EXPECT_EQ(store.Size(t), 4u);
+  EXPECT_EQ(store.Size(u), 12u);
+
+  store.Data(u)[3 * 2 + 1] = 5.0;
+  store.Resize(6);
+  EXPECT_EQ(store.Size(u), 18u);
+  EXPECT_DOUBLE_EQ(store.Get(u, 2, 1), 5.0);
+  EXPECT_DOUBLE_EQ(store.Get(u, 5, 2), 0.0);
+}
+
+TEST(CoupledFieldStoreTest, ScalarStats) {
+  CoupledFieldStore store;
+  size_t t = store.AddField("T", 1);
+  store.Resize(5);
+  const double values[] = {310.0, 300.0, 450.0, 320.0, 370.0};
+  std::copy(values, values + 5, store.Data(t));
+
+  FieldStats stats = store.ScalarStats(t);
+  EXPECT_EQ(stats.count, 5u);
+  EXPECT_DOUBLE_EQ(stats.min, 300.0);
+  EXPECT_DOUBLE_EQ(stats.max, 450.0);
+  EXPECT_DOUBLE_EQ(stats.Mean(), 350.0);
+
+  CoupledFieldStore empty;
+  EXPECT_EQ(empty.ScalarStats(empty.AddField("T", 1)).count, 0u);
+}
+
+TEST(CoupledFieldStoreTest, MapToColors) {
+  CoupledFieldStore store;
+  size_t t = store.AddField("T", 1);
+  store.Resize(4);
+  const double values[] = {250.0, 300.0, 375.0, 500.0};
+  std::copy(values, values + 4, store.Data(t));
+
+  store.MapToColors(t, 300.0, 450.0);
+  const double red[] = {0.0, 0.0, 0.5, 1.0};
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_DOUBLE_EQ(store.GetRed(i), red[i]);
+    EXPECT_DOUBLE_EQ(store.GetGreen(i), 0.0);
+    EXPECT_DOUBLE_EQ(store.GetBlue(i), 1.0 - red[i]);
+  }
+}
+
+// Statistics of several fields and colors in one pass, across blocks
+TEST(CoupledFieldStoreTest, Apply) {
+  CoupledFieldStore store;
+  size_t t = store.AddField("T", 1);
+  size_t o2 = store.AddField("O2", 1);
+  size_t u = store.AddField("U", 3);
+  const size_t n = 5000;
+  store.Resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    store.Data(t)[i] = 300.0 + (i % 151);
+    store.Data(o2)[i] = 0.2 - 1e-5 * i;
+    store.Data(u)[3 * i] = 3.0;
+    store.Data(u)[3 * i + 2] = i == 4000 ? 5.0 : 4.0;
+  }
+
+  std::vector<FieldStats> stats;
+  store.Apply({t, o2, u}, t, 300.0, 450.0, &stats);
+  ASSERT_EQ(stats.size(), 3u);
+  const FieldStats expected = store.ScalarStats(t);
+  EXPECT_EQ(stats[0].count, n);
+  EXPECT_DOUBLE_EQ(stats[0].min, expected.min);
+  EXPECT_DOUBLE_EQ(stats[0].max, expected.max);
+  EXPECT_NEAR(stats[0].sum, expected.sum, 1e-9 * expected.sum);
+  EXPECT_DOUBLE_EQ(stats[1].max, 0.2);
+  EXPECT_NEAR(stats[1].min, 0.2 - 1e-5 * (n - 1), 1e-12);
+  // Magnitude of the vector field
+  EXPECT_DOUBLE_EQ(stats[2].min, 5.0);
+  EXPECT_NEAR(stats[2].max, std::sqrt(34.0), 1e-12);
+
+  // The colors of the last block too
+  EXPECT_DOUBLE_EQ(store.GetRed(n - 1), (store.Data(t)[n - 1] - 300.0) / 150.0);
+}
+
+TEST(CoupledFieldStoreTest, ParseFieldList) {
+  std::vector<FieldSpec> fields;
+  std::string error;
+  ASSERT_TRUE(ParseFieldList("T, O2 U:vector,C:scalar", &fields, &error))
+      << error;
+  ASSERT_EQ(fields.size(), 4u);
+  EXPECT_EQ(fields[0].name, "T");
+  EXPECT_EQ(fields[0].components, 1);
+  EXPECT_EQ(fields[1].name, "O2");
+  EXPECT_EQ(fields[2].name, "U");
+  EXPECT_EQ(fields[2].components, 3);
+  EXPECT_EQ(fields[3].components, 1);
+
+  ASSERT_TRUE(ParseFieldList("", &fields, &error));
+  EXPECT_TRUE(fields.empty());
+  EXPECT_FALSE(ParseFieldList("T, U:tensor", &fields, &error));
+  EXPECT_FALSE(ParseFieldList("T, :vector", &fields, &error));
+  EXPECT_FALSE(ParseFieldList("T, O2, T", &fields, &error));
+}
+
+}  // namespace bdm
@@ -0,0 +1,94 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "coupling_log.h"
+
+namespace bdm {
+
+static const char* kLogFile = "coupling-log-test.log";
+
+static std::string ReadLog() {
+  std::ifstream in(kLogFile);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+static int Count(const std::string& text, const std::string& pattern) {
+  int count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+TEST(CouplingLogTest, Levels) {
+  auto* log = CouplingLog::Get();
+  ASSERT_TRUE(log->Configure(CouplingLog::kInfo, kLogFile, false));
+  int evaluated = 0;
+  auto value = [&]() { return ++evaluated; };
+  COUPLING_LOG(CouplingLog::kInfo, "info ", value());
+  COUPLING_LOG(CouplingLog::kDebug, "debug ", value());
+  // Above COUPLING_LOG_MAX_LEVEL, removed at compile time
+  COUPLING_LOG(CouplingLog::kTrace, "trace ", value());
+  log->Close();
+
+  // The disabled statements do not evaluate their arguments
+  EXPECT_EQ(1, evaluated);
+  EXPECT_EQ("[info] info 1\n", ReadLog());
+  std::remove(kLogFile);
+}
+
+TEST(CouplingLogTest, SamplingAndRateLimiting) {
+  auto* log = CouplingLog::Get();
+  ASSERT_TRUE(log->Configure(CouplingLog::kDebug, kLogFile, true));
+  for (int i = 0; i < 10; ++i) {
+    COUPLING_LOG_EVERY_N(CouplingLog::kDebug, 4, "sampled ", i);
+    COUPLING_LOG_EVERY_SECONDS(CouplingLog::kInfo, 3600, "limited ", i);
+  }
+  log->Close();
+
+  const std::string text = ReadLog();
+  EXPECT_EQ(3, Count(text, "sampled"));
+  EXPECT_NE(std::string::npos, text.find("[debug] sampled 8\n"));
+  EXPECT_EQ(1, Count(text, "limited"));
+  EXPECT_NE(std::string::npos, text.find("[info] limited 0\n"));
+  std::remove(kLogFile);
+}
+
+TEST(CouplingLogTest, SkippedNote) {
+  CouplingLog::Site site;
+  EXPECT_TRUE(site.Limit(0));
+  EXPECT_EQ("", site.SkippedNote());
+  EXPECT_FALSE(site.Limit(3600));
+  EXPECT_FALSE(site.Limit(3600));
+  EXPECT_TRUE(site.Limit(0));
+  EXPECT_EQ(" (2 similar messages skipped)", site.SkippedNote());
+}
+
+TEST(CouplingLogTest, ParseLevel) {
+  CouplingLog::Level level;
+  ASSERT_TRUE(CouplingLog::ParseLevel("warning", &level));
+  EXPECT_EQ(CouplingLog::kWarning, level);
+  EXPECT_FALSE(CouplingLog::ParseLevel("verbose", &level));
+}
+
+}  // namespace bdm
@@ -0,0 +1,149 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "coupling_snapshot.h"
+
+namespace bdm {
+
+CouplingSnapshot MakeTestSnapshot(uint64_t window) {
+  CouplingSnapshot snapshot;
+  snapshot.window = window;
+  snapshot.timestep = 4 * window;
+  snapshot.time = 0.5 * window;
+  snapshot.received_hash = 42;
+  snapshot.positions = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+  snapshot.diameters = {0.1, 0.2, 0.3};
+  snapshot.temperatures = {300, 310, 320};
+  snapshot.heat_releases = {1e-3, 2e-3, 3e-3};
+  snapshot.vertex_cells = {7, -1, 9};
+  snapshot.heat_targets = {0, 0, 1};
+  return snapshot;
+}
+
+TEST(CouplingSnapshotTest, RoundTrip) {
+  const std::string file_name = "coupling-snapshot-test.snap";
+  const CouplingSnapshot written = MakeTestSnapshot(3);
+  std::string error;
+  ASSERT_TRUE(WriteCouplingSnapshot(file_name, written, &error)) << error;
+
+  CouplingSnapshot read;
+  ASSERT_TRUE(ReadCouplingSnapshot(file_name, &read, &error)) << error;
+  EXPECT_EQ(3u, read.window);
+  EXPECT_EQ(12u, read.timestep);
+  EXPECT_DOUBLE_EQ(1.5, read.time);
+  EXPECT_EQ(42u, read.received_hash);
+  EXPECT_EQ(3u, read.GetNumAgents());
+  EXPECT_EQ(written.positions, read.positions);
+  EXPECT_EQ(written.diameters, read.diameters);
+  EXPECT_EQ(written.temperatures, read.temperatures);
+  EXPECT_EQ(written.heat_releases, read.heat_releases);
+  EXPECT_EQ(written.vertex_cells, read.vertex_cells);
+  EXPECT_EQ(written.heat_targets, read.heat_targets);
+  std::remove(file_name.c_str());
+}
+
+// Just-in-time mapping: the agents without their mapping
+TEST(CouplingSnapshotTest, WithoutMapping) {
+  const std::string file_name = "coupling-snapshot-test.snap";
+  CouplingSnapshot written = MakeTestSnapshot(1);
+  written.vertex_cells.clear();
+  written.heat_targets.clear();
+  std::string error;
+  ASSERT_TRUE(WriteCouplingSnapshot(file_name, written, &error)) << error;
+
+  CouplingSnapshot read = MakeTestSnapshot(2);
+  ASSERT_TRUE(ReadCouplingSnapshot(file_name, &read, &error)) << error;
+  EXPECT_EQ(3u, read.GetNumAgents());
+  EXPECT_TRUE(read.vertex_cells.empty());
+  EXPECT_TRUE(read.heat_targets.empty());
+  std::remove(file_name.c_str());
+}
+
+TEST(CouplingSnapshotTest, RejectsIncompleteAndForeignFiles) {
+  const std::string file_name = "coupling-snapshot-test.snap";
+  std::string error;
+  ASSERT_TRUE(WriteCouplingSnapshot(file_name, MakeTestSnapshot(1), &error));
+
+  // Cut off the last array
+  std::vector<char> bytes;
+  {
+    std::ifstream in(file_name, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  {
+    std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size() - 8);
+  }
+  CouplingSnapshot read;
+  EXPECT_FALSE(ReadCouplingSnapshot(file_name, &read, &error));
+  EXPECT_NE(std::string::npos, error.find("incomplete"));
+
+  // A snapshot of the OpenFOAM adapter
+  bytes[0] = 'C';
+  {
+    std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size());
+  }
+  EXPECT_FALSE(ReadCouplingSnapshot(file_name, &read, &error));
+
+  EXPECT_FALSE(ReadCouplingSnapshot("missing.snap", &read, &error));
+  std::remove(file_name.c_str());
+}
+
+TEST(CouplingSnapshotTest, BackgroundWriter) {
+  const std::string dir = "coupling-snapshot-test-dir";
+  std::string error;
+  {
+    CouplingSnapshotWriter writer(dir, "cells");
+    EXPECT_TRUE(writer.Write(MakeTestSnapshot(10), &error));
+    EXPECT_TRUE(writer.Write(MakeTestSnapshot(20), &error));
+    EXPECT_TRUE(writer.Wait(&error)) << error;
+  }
+
+  for (uint64_t window : {10, 20}) {
+    const std::string file_name = CouplingSnapshotFile(dir, "cells", window);
+    EXPECT_EQ(dir + "/cells-" + std::to_string(window) + ".snap", file_name);
+    CouplingSnapshot read;
+    ASSERT_TRUE(ReadCouplingSnapshot(file_name, &read, &error)) << error;
+    EXPECT_EQ(window, read.window);
+    std::remove(file_name.c_str());
+  }
+  std::remove(dir.c_str());
+}
+
+TEST(CouplingSnapshotTest, BackgroundWriterReportsFailures) {
+  CouplingSnapshotWriter writer("/nonexistent/snapshots", "cells");
+  std::string error;
+  EXPECT_TRUE(writer.Write(MakeTestSnapshot(1), &error));
+  EXPECT_FALSE(writer.Wait(&error));
+  EXPECT_NE(std::string::npos, error.find("cells-1.snap"));
+  // The failure is reported once
+  EXPECT_TRUE(writer.Wait(&error));
+}
+
+TEST(CouplingSnapshotTest, HashValues) {
+  const std::vector<double> a = {0, 1, 2};
+  std::vector<double> b = a;
+  EXPECT_EQ(HashValues(a.data(), a.size()), HashValues(b.data(), b.size()));
+  b[2] = 2.000001;
+  EXPECT_NE(HashValues(a.data(), a.size()), HashValues(b.data(), b.size()));
+}
+
+}  // namespace bdm
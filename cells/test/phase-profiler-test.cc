@@ -0,0 +1,79 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "phase_profiler.h"
+
+namespace bdm {
+
+TEST(PhaseProfilerTest, Percentiles) {
+  PhaseProfiler profiler(true);
+  const size_t read = profiler.AddPhase("read");
+  const size_t apply = profiler.AddPhase("apply");
+  profiler.AddPhase("unused");
+  // Durations 1..100 us, in reverse order
+  for (int i = 100; i >= 1; --i) {
+    profiler.Record(read, 1000 * i, i);
+  }
+  profiler.Record(apply, 0, 7);
+
+  auto summaries = profiler.Summarize();
+  ASSERT_EQ(2u, summaries.size());
+  EXPECT_EQ("read", summaries[0].phase);
+  EXPECT_EQ(100u, summaries[0].count);
+  EXPECT_DOUBLE_EQ(5050.0, summaries[0].total);
+  EXPECT_DOUBLE_EQ(50.5, summaries[0].mean);
+  EXPECT_DOUBLE_EQ(50.0, summaries[0].p50);
+  EXPECT_DOUBLE_EQ(99.0, summaries[0].p99);
+  EXPECT_DOUBLE_EQ(100.0, summaries[0].max);
+  EXPECT_DOUBLE_EQ(7.0, summaries[1].p99);
+  EXPECT_NE(std::string::npos, profiler.Report().find("apply"));
+}
+
+TEST(PhaseProfilerTest, DisabledScope) {
+  PhaseProfiler profiler;
+  const size_t phase = profiler.AddPhase("simulate");
+  { PhaseProfiler::Scope scope(&profiler, phase); }
+  EXPECT_EQ(0u, profiler.GetNumEvents());
+
+  profiler.SetEnabled(true);
+  { PhaseProfiler::Scope scope(&profiler, phase); }
+  EXPECT_EQ(1u, profiler.GetNumEvents());
+}
+
+TEST(PhaseProfilerTest, Trace) {
+  PhaseProfiler profiler(true);
+  const size_t phase = profiler.AddPhase("read");
+  profiler.Record(phase, 1700000000000000, 250);
+  const std::string file_name = "phase-profiler-test.json";
+  ASSERT_TRUE(profiler.WriteTrace(file_name, "cells", 3));
+
+  std::ifstream in(file_name);
+  std::stringstream content;
+  content << in.rdbuf();
+  const std::string trace = content.str();
+  EXPECT_NE(std::string::npos, trace.find("\"traceEvents\""));
+  EXPECT_NE(std::string::npos, trace.find("\"name\":\"cells\""));
+  EXPECT_NE(std::string::npos,
+            trace.find("\"name\":\"read\",\"cat\":\"coupling\",\"ph\":\"X\","
+                       "\"ts\":1700000000000000,\"dur\":250,\"pid\":3"));
+  std::remove(file_name.c_str());
+}
+
+}  // namespace bdm
@@ -0,0 +1,105 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "record_file.h"
+
+namespace bdm {
+
+// Write a record file the way the FieldRecorder of the OpenFOAM adapter does:
+// 3 vertices, value of vertex v at time t = 100 * t + v. The last record is
+// incomplete (still being written).
+std::string WriteTestRecord(const char* magic = "CPLREC01") {
+  std::string file_name = "record-file-test.rec";
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  RecordHeader header;
+  std::memcpy(header.magic, magic, sizeof(header.magic));
+  header.num_vertices = 3;
+  header.num_components = 1;
+  header.window_size = 0.5;
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  std::vector<double> coords = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+  out.write(reinterpret_cast<const char*>(coords.data()),
+            coords.size() * sizeof(double));
+  for (double t : {0.0, 0.5, 1.0}) {
+    std::vector<double> record = {t, 100 * t, 100 * t + 1, 100 * t + 2};
+    out.write(reinterpret_cast<const char*>(record.data()),
+              record.size() * sizeof(double));
+  }
+  double partial = 1.5;
+  out.write(reinterpret_cast<const char*>(&partial), sizeof(partial));
+  return file_name;
+}
+
+TEST(RecordFileTest, Layout) {
+  std::string file_name = WriteTestRecord();
+  RecordFile record;
+  std::string error;
+  ASSERT_TRUE(record.Open(file_name, &error)) << error;
+  EXPECT_EQ(3u, record.GetNumVertices());
+  EXPECT_EQ(1u, record.GetNumComponents());
+  EXPECT_EQ(3u, record.GetNumRecords());
+  EXPECT_DOUBLE_EQ(0.5, record.GetWindowSize());
+  EXPECT_DOUBLE_EQ(1.0, record.GetCoordinates()[3]);
+  EXPECT_DOUBLE_EQ(1.0, record.GetTime(2));
+  EXPECT_DOUBLE_EQ(52.0, record.GetValues(1)[2]);
+  record.Close();
+  std::remove(file_name.c_str());
+}
+
+TEST(RecordFileTest, Sample) {
+  std::string file_name = WriteTestRecord();
+  RecordFile record;
+  std::string error;
+  ASSERT_TRUE(record.Open(file_name, &error)) << error;
+
+  std::vector<int64_t> vertices = {2, 0};
+  std::vector<double> values(2);
+  // On a record
+  record.Sample(0.5, vertices.data(), vertices.size(), values.data());
+  EXPECT_DOUBLE_EQ(52.0, values[0]);
+  EXPECT_DOUBLE_EQ(50.0, values[1]);
+  // Between two records
+  record.Sample(0.75, vertices.data(), vertices.size(), values.data());
+  EXPECT_DOUBLE_EQ(77.0, values[0]);
+  EXPECT_DOUBLE_EQ(75.0, values[1]);
+  // Outside of the recorded times
+  record.Sample(-1.0, vertices.data(), vertices.size(), values.data());
+  EXPECT_DOUBLE_EQ(2.0, values[0]);
+  record.Sample(5.0, vertices.data(), vertices.size(), values.data());
+  EXPECT_DOUBLE_EQ(102.0, values[0]);
+  record.Close();
+  std::remove(file_name.c_str());
+}
+
+TEST(RecordFileTest, BadFile) {
+  RecordFile record;
+  std::string error;
+  EXPECT_FALSE(record.Open("does-not-exist.rec", &error));
+  EXPECT_FALSE(error.empty());
+
+  std::string file_name = WriteTestRecord("NOTAREC!");
+  error.clear();
+  EXPECT_FALSE(record.Open(file_name, &error));
+  EXPECT_NE(std::string::npos, error.find("magic"));
+  std::remove(file_name.c_str());
+}
+
+}  // namespace bdm
@@ -0,0 +1,86 @@
+// -----------------------------------------------------------------------------
+//
+// Copyright (C) 2021 CERN & University of Surrey for the benefit of the
+// BioDynaMo collaboration. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+//
+// See the LICENSE file distributed with this work for details.
+// See the NOTICE file distributed with this work for additional information
+// regarding copyright ownership.
+//
+// -----------------------------------------------------------------------------
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "scatter_add.h"
+
+namespace bdm {
+
+TEST(ScatterAddTest, MatchesSerialSum) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int64_t> target(-1, 99);
+  std::uniform_real_distribution<double> value(0.0, 1.0);
+
+  const size_t n = 10000;
+  std::vector<int64_t> targets(n);
+  std::vector<double> values(n);
+  std::vector<double> expected(100, 0.0);
+  size_t skipped = 0;
+  double total = 0.0;
+  for (size_t s = 0; s < n; ++s) {
+    targets[s] = target(rng);
+    values[s] = value(rng);
+    if (targets[s] >= 0) {
+      expected[targets[s]] += values[s];
+      total += values[s];
+    } else {
+      skipped++;
+    }
+  }
+
+  ScatterAddPlan plan;
+  plan.Build(targets.data(), n, 100);
+  EXPECT_EQ(plan.GetNumTargets(), 100u);
+  EXPECT_EQ(plan.GetNumSkipped(), skipped);
+
+  std::vector<double> sums(100);
+  plan.Apply(values.data(), sums.data());
+  double deposited = 0.0;
+  for (size_t t = 0; t < 100; ++t) {
+    // Same summation order as the serial loop
+    EXPECT_EQ(sums[t], expected[t]);
+    deposited += sums[t];
+  }
+  EXPECT_NEAR(deposited, total, 1e-9);
+}
+
+TEST(ScatterAddTest, EmptyTargets) {
+  const int64_t targets[] = {-1, -1};
+  const double values[] = {1.0, 2.0};
+  ScatterAddPlan plan;
+  plan.Build(targets, 2, 3);
+  std::vector<double> sums(3, -1.0);
+  plan.Apply(values, sums.data());
+  EXPECT_EQ(sums, std::vector<double>(3, 0.0));
+  EXPECT_EQ(plan.GetNumSkipped(), 2u);
+}
+
+TEST(ScatterAddTest, Rebuild) {
+  // The plan of the previous window must not leak into the next one
+  ScatterAddPlan plan;
+  const int64_t first[] = {2, 0, 2, 1, 0};
+  plan.Build(first, 5, 3);
+  const int64_t second[] = {1, -1, 1};
+  const double values[] = {1.0, 2.0, 4.0};
+  plan.Build(second, 3, 2);
+  EXPECT_EQ(plan.GetNumTargets(), 2u);
+  EXPECT_EQ(plan.GetNumSkipped(), 1u);
+  std::vector<double> sums(2, -1.0);
+  plan.Apply(values, sums.data());
+  EXPECT_EQ(sums, std::vector<double>({0.0, 5.0}));
+}
+
+}  // namespace bdm
@@ -0,0 +1,98 @@
+#!/bin/bash
+# Restart the coupled run from the latest coupling window that both
+# participants have a complete snapshot of, or from the given window:
+#
+#   ./restart.sh        # latest common snapshot
+#   ./restart.sh 300    # snapshot of window 300
+#
+# The snapshots are written every snapshotInterval windows by the OpenFOAM
+# adapter (cavity_temp/system/preciceDict) and every snapshot_every windows
+# by the cells participant (cells/bdm.json), both into snapshots/. Use the
+# same interval on both sides.
+#
+# preCICE cannot restart a coupling: both participants start a new one, with
+# precice-config-restart.xml, whose max-time is the time that remained after
+# the window. OpenFOAM restores its fields and its time from its snapshot
+# (restartWindow), the cells participant its agents and their mapping to the
+# OpenFOAM meshes (restart_window). The cells participant must be built.
+set -e -u
+
+root="$(cd "$(dirname "$0")" && pwd)"
+snapshots="$root/snapshots"
+case_dir="$root/cavity_temp"
+
+if [ ! -x "$root/cells/build/cells" ]; then
+    echo "Build the cells participant first (bdm build in $root/cells)"
+    exit 1
+fi
+
+participant=$(foamDictionary "$case_dir/system/preciceDict" -entry participant -value)
+config=$(foamDictionary "$case_dir/system/preciceDict" -entry preciceConfig -value | tr -d '"')
+config="$(cd "$case_dir" && realpath "$config")"
+nProcs=$(find "$case_dir" -maxdepth 1 -type d -name 'processor*' | wc -l)
+
+# Is the snapshot of OpenFOAM complete for a window (on every rank)?
+openfoam_snapshot() {
+    if [ "$nProcs" -eq 0 ]; then
+        [ -f "$snapshots/$participant-$1.snap" ]
+        return
+    fi
+    for ((proc = 0; proc < nProcs; proc++)); do
+        [ -f "$snapshots/$participant-$1.snap.proc$proc" ] || return 1
+    done
+}
+
+window="${1:-}"
+if [ -z "$window" ]; then
+    for file in $(ls "$snapshots"/cells-*.snap 2>/dev/null | sed 's|.*/cells-\([0-9]*\)\.snap|\1|' | sort -n -r); do
+        if openfoam_snapshot "$file"; then
+            window="$file"
+            break
+        fi
+    done
+fi
+if [ -z "$window" ] || [ ! -f "$snapshots/cells-$window.snap" ] || ! openfoam_snapshot "$window"; then
+    echo "No snapshot of both participants in $snapshots${window:+ for window $window}"
+    exit 1
+fi
+
+# Remaining time of the coupling
+dt=$(sed -n 's|.*<time-window-size value="\([^"]*\)".*|\1|p' "$config")
+maxTime=$(sed -n 's|.*<max-time value="\([^"]*\)".*|\1|p' "$config")
+remaining=$(awk -v n="$window" -v dt="$dt" -v end="$maxTime" 'BEGIN { print end - n * dt }')
+if awk -v r="$remaining" -v dt="$dt" 'BEGIN { exit !(r < 0.5 * dt) }'; then
+    echo "The snapshot of window $window is at the end of the coupling ($maxTime s)"
+    exit 1
+fi
+echo "Restarting from window $window (t = $(awk -v n="$window" -v dt="$dt" 'BEGIN { print n * dt }') s), $remaining s to go"
+
+restart_config="$root/precice-config-restart.xml"
+sed "s|<max-time value=\"[^\"]*\"|<max-time value=\"$remaining\"|" "$config" > "$restart_config"
+
+# The preciceDict is changed for the restart and restored afterwards
+cp "$case_dir/system/preciceDict" "$case_dir/system/preciceDict.orig"
+trap 'mv "$case_dir/system/preciceDict.orig" "$case_dir/system/preciceDict"; rm -f "$restart_config"' EXIT
+foamDictionary "$case_dir/system/preciceDict" -entry preciceConfig -set '"../precice-config-restart.xml"' > /dev/null
+foamDictionary "$case_dir/system/preciceDict" -entry restartWindow -set "$window" > /dev/null
+
+rm -rf "$root/precice-run"
+
+(
+    cd "$root/cells"
+    ./build/cells --inline-config \
+        "{\"bdm::CouplingParam\": {\"precice_config\": \"../precice-config-restart.xml\", \"restart_window\": $window}}"
+) > "$root/cells/log.restart" 2>&1 &
+cells_pid=$!
+
+(
+    cd "$case_dir"
+    solver=$(foamDictionary system/controlDict -entry application -value)
+    if [ "$nProcs" -gt 0 ]; then
+        mpirun -np "$nProcs" "$solver" -parallel
+    else
+        "$solver"
+    fi
+) > "$case_dir/log.restart" 2>&1
+
+wait "$cells_pid"
+echo "Restarted run completed (logs: cavity_temp/log.restart, cells/log.restart)"